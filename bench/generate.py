@@ -0,0 +1,137 @@
+import argparse
+import os
+import random
+import sys
+
+# Clauses are formatted and written in chunks of this many lines
+CHUNK = 1 << 16
+
+
+class Weights:
+    """Draws weights (as numerator/denominator pairs) from a distribution."""
+
+    def __init__(self, spec, rng):
+        kind, _, arg = spec.partition(":")
+        self.kind = kind
+        self.rng = rng
+        if kind == "dyadic":
+            # k/2^bits
+            self.bits = int(arg or 8)
+        elif kind == "decimal":
+            # 0.d...d with a fixed number of digits
+            self.digits = int(arg or 3)
+        elif kind == "fraction":
+            # p/q with q uniform in [2, max_denom]
+            self.max_denom = int(arg or 1000)
+        elif kind == "classes":
+            # A fixed set of distinct decimal weights, shared by many variables
+            count = int(arg or 16)
+            self.classes = [(rng.randrange(1, 1000), 1000) for _ in range(count)]
+        else:
+            raise ValueError("Unknown weight distribution: " + spec)
+
+    def draw(self):
+        """Return (numerator, denominator) with 0 < numerator < denominator."""
+        if self.kind == "dyadic":
+            denom = 1 << self.bits
+            return self.rng.randrange(1, denom), denom
+        elif self.kind == "decimal":
+            denom = 10 ** self.digits
+            return self.rng.randrange(1, denom), denom
+        elif self.kind == "fraction":
+            denom = self.rng.randrange(2, self.max_denom + 1)
+            return self.rng.randrange(1, denom), denom
+        else:
+            return self.rng.choice(self.classes)
+
+    def format(self, num, denom):
+        if self.kind in ("decimal", "classes"):
+            digits = len(str(denom)) - 1
+            return "0." + str(num).rjust(digits, "0")
+        return "%d/%d" % (num, denom)
+
+
+def weight_lines(args, weights, rng):
+    """Yield the lines giving the weights, in the chosen format."""
+    chosen = [None] * (args.vars + 1)
+    for var in range(1, args.vars + 1):
+        if rng.random() < args.weighted:
+            chosen[var] = weights.draw()
+
+    if args.format == "minic2d":
+        entries = []
+        for var in range(1, args.vars + 1):
+            if chosen[var] is None:
+                entries.append("1 1")
+            else:
+                num, denom = chosen[var]
+                entries.append(weights.format(num, denom) + " "
+                               + weights.format(denom - num, denom))
+        yield "c weights " + " ".join(entries) + "\n"
+        return
+
+    lines = []
+    for var in range(1, args.vars + 1):
+        if chosen[var] is None:
+            continue
+        num, denom = chosen[var]
+        if args.format == "cachet":
+            lines.append("w %d %s\n" % (var, weights.format(num, denom)))
+        else:
+            lines.append("w %d %s 0\n" % (var, weights.format(num, denom)))
+            lines.append("w -%d %s 0\n" % (var, weights.format(denom - num, denom)))
+        if len(lines) >= CHUNK:
+            yield "".join(lines)
+            lines = []
+    yield "".join(lines)
+
+
+def clause_lines(args, num_clauses, rng):
+    """Yield random clauses (and XORs) of width args.width."""
+    lines = []
+    for _ in range(num_clauses):
+        literals = []
+        for _ in range(args.width):
+            var = rng.randrange(1, args.vars + 1)
+            literals.append(str(var) if rng.getrandbits(1) else str(-var))
+        if rng.random() < args.xors:
+            lines.append("x " + " ".join(literals) + " 0\n")
+        else:
+            lines.append(" ".join(literals) + " 0\n")
+        if len(lines) >= CHUNK:
+            yield "".join(lines)
+            lines = []
+    yield "".join(lines)
+
+
+def generate(args, out):
+    rng = random.Random(args.seed)
+    weights = Weights(args.denominators, rng)
+    num_clauses = int(args.vars * args.ratio)
+    out.write("p cnf %d %d\n" % (args.vars, num_clauses))
+    for chunk in weight_lines(args, weights, rng):
+        out.write(chunk)
+    for chunk in clause_lines(args, num_clauses, rng):
+        out.write(chunk)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Generate a random weighted CNF for benchmarking.")
+    parser.add_argument("--vars", type=int, help="Number of variables.", default=1000)
+    parser.add_argument("--ratio", type=float, help="Clauses per variable.", default=2.0)
+    parser.add_argument("--width", type=int, help="Literals per clause.", default=3)
+    parser.add_argument("--xors", type=float, help="Fraction of clauses written as XORs (for dexor).", default=0.0)
+    parser.add_argument("--format", choices=["cachet", "minic2d", "mc20"], help="Format of the weights.", default="cachet")
+    parser.add_argument("--denominators", type=str,
+                        help="Distribution of weights: dyadic:BITS, decimal:DIGITS, fraction:MAX_DENOM or classes:COUNT.",
+                        default="decimal:3")
+    parser.add_argument("--weighted", type=float, help="Fraction of variables with a weight.", default=1.0)
+    parser.add_argument("--seed", type=int, help="Seed for the random number generator.", default=0)
+    parser.add_argument("--output", type=str, help="File to write instead of stdout.", default="")
+    args = parser.parse_args()
+    if args.output:
+        with open(args.output + ".tmp", "w") as out:
+            generate(args, out)
+        os.replace(args.output + ".tmp", args.output)
+    else:
+        generate(args, sys.stdout)
@@ -0,0 +1,262 @@
+/******************************************
+Copyright (c) 2020, Jeffrey Dudek
+******************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../lib/memorybuffer.h"
+#include "../lib/streambuffer.h"
+#include "src/bignum.h"
+#include "src/gadget.h"
+#include "src/rational.h"
+
+// Every allocation made through operator new, to report allocations per op
+static std::atomic<size_t> allocations(0);
+
+void *operator new(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  void *p = malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void *p) noexcept {
+  free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+  free(p);
+}
+
+namespace {
+  // Shortest time to run each benchmark for
+  const double kMinSeconds = 0.2;
+
+  // Results are accumulated here so that the work is not optimized away
+  volatile uint64_t sink;
+
+  /**
+   * Time [op](i), which performs [ops_per_call] operations, over increasing
+   * numbers of calls until it runs for kMinSeconds, and print the time and
+   * allocations per operation.
+   */
+  template <typename Op>
+  void bench(const std::string &name, size_t ops_per_call, Op op) {
+    op(0);  // Warm up
+    for (size_t calls = 1;; calls *= 2) {
+      size_t allocated = allocations.load();
+      auto start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < calls; i++) {
+        op(i);
+      }
+      double seconds = std::chrono::duration_cast<std::chrono::duration<double>>(
+        std::chrono::steady_clock::now() - start).count();
+      if (seconds >= kMinSeconds) {
+        double ops = static_cast<double>(calls) * ops_per_call;
+        printf("%-32s %14.1f ns/op %10.2f allocs/op\n", name.c_str(),
+               seconds * 1e9 / ops, (allocations.load() - allocated) / ops);
+        return;
+      }
+    }
+  }
+
+  /**
+   * Counts the literals written by chain_formula.
+   */
+  struct CountingSink {
+    uint64_t literals = 0;
+    void add_literal(int literal) { literals += literal; }
+    void end_clause() { literals++; }
+  };
+
+  void bench_rational(std::mt19937_64 *rng) {
+    const std::vector<std::string> inputs = {
+      "0.5", "0.25", "0.123", "0.987654321", "0.123456789012345", "1/3",
+      "355/113", "12345/65536", "0.000001", "1"
+    };
+    bench("Rational::parse", inputs.size(), [&](size_t) {
+      for (const std::string &input : inputs) {
+        sink += deweight::Rational::parse(input).denom;
+      }
+    });
+
+    std::vector<deweight::Rational> weights;
+    for (int i = 0; i < 1024; i++) {
+      int64_t denom = 2 + (*rng)() % 1000000;
+      weights.push_back(deweight::Rational(1 + (*rng)() % (denom - 1), denom));
+    }
+    const char *names[] = {"up", "down", "near"};
+    deweight::RoundingStrategy strategies[] = {
+      deweight::RoundingStrategy::up, deweight::RoundingStrategy::down,
+      deweight::RoundingStrategy::near
+    };
+    for (int s = 0; s < 3; s++) {
+      bench(std::string("Rational::round ") + names[s], weights.size(),
+            [&](size_t) {
+        for (const deweight::Rational &weight : weights) {
+          sink += weight.round(1 << 16, strategies[s]).num;
+        }
+      });
+    }
+
+    std::vector<deweight::Rational> unsimplified;
+    for (const deweight::Rational &weight : weights) {
+      int64_t factor = 1 + (*rng)() % 1000;
+      unsimplified.push_back(
+        deweight::Rational(weight.num * factor, weight.denom * factor));
+    }
+    bench("Rational::simplify", unsimplified.size(), [&](size_t) {
+      for (const deweight::Rational &weight : unsimplified) {
+        sink += weight.simplify().denom;
+      }
+    });
+  }
+
+  void bench_chain_formula(std::mt19937_64 *rng) {
+    std::vector<int> vars;
+    for (int i = 1; i <= 30; i++) {
+      vars.push_back(i);
+    }
+    for (size_t bits = 1; bits <= 30; bits++) {
+      // An odd count, so that the chain uses every variable
+      uint64_t num_solutions = ((*rng)() % (uint64_t(1) << bits)) | 1;
+      bench("chain_formula " + std::to_string(bits) + " bits", 1,
+            [&](size_t) {
+        CountingSink counter;
+        deweight::chain_formula(vars.data(), bits, num_solutions, 0,
+                                &counter);
+        sink += counter.literals;
+      });
+    }
+  }
+
+  /**
+   * Get a random number of [limbs] 64-bit limbs.
+   */
+  deweight::BigNum random_bignum(size_t limbs, std::mt19937_64 *rng) {
+    std::vector<uint64_t> factors;
+    for (size_t i = 0; i < limbs; i++) {
+      factors.push_back((*rng)() | (uint64_t(1) << 63));
+    }
+    return deweight::BigNum::product(factors);
+  }
+
+  void bench_bignum(std::mt19937_64 *rng) {
+    for (size_t limbs = 1; limbs <= (1 << 14); limbs *= 8) {
+      deweight::BigNum a = random_bignum(limbs, rng);
+      deweight::BigNum b = random_bignum(limbs, rng);
+      bench("BigNum *= " + std::to_string(limbs) + " limbs", 1, [&](size_t) {
+        deweight::BigNum product = a;
+        product *= b;
+        sink += product.num_limbs();
+      });
+      bench("BigNum::to_string " + std::to_string(limbs) + " limbs", 1,
+            [&](size_t) {
+        sink += a.to_string().size();
+      });
+    }
+  }
+
+  void bench_parsing(std::mt19937_64 *rng) {
+    // Lines of clauses, as in a DIMACS file
+    const size_t num_lines = 1 << 16;
+    const size_t literals_per_line = 3;
+    std::string text;
+    for (size_t i = 0; i < num_lines; i++) {
+      for (size_t j = 0; j < literals_per_line; j++) {
+        int64_t var = 1 + (*rng)() % 1000000;
+        text.append(std::to_string((*rng)() % 2 ? var : -var));
+        text.push_back(' ');
+      }
+      text.append("0\n");
+    }
+    const size_t ints_per_line = literals_per_line + 1;
+    const size_t num_ints = num_lines * ints_per_line;
+
+    bench("MemoryBuffer::parseInt", num_ints, [&](size_t) {
+      MemoryBuffer in(text.data(), text.size());
+      int value;
+      for (size_t i = 0; i < num_lines; i++) {
+        for (size_t j = 0; j < ints_per_line; j++) {
+          in.parseInt(value, i);
+          sink += value;
+        }
+        in.skipLine();
+      }
+    });
+    bench("MemoryBuffer::skipLine", num_lines, [&](size_t) {
+      MemoryBuffer in(text.data(), text.size());
+      for (size_t i = 0; i < num_lines; i++) {
+        in.skipLine();
+      }
+      sink += in.position();
+    });
+    std::string token;
+    bench("MemoryBuffer::parseString", num_ints, [&](size_t) {
+      MemoryBuffer in(text.data(), text.size());
+      for (size_t i = 0; i < num_lines; i++) {
+        for (size_t j = 0; j < ints_per_line; j++) {
+          in.parseString(token);
+          sink += token.size();
+        }
+        in.skipLine();
+      }
+    });
+
+    bench("StreamBuffer::parseInt", num_ints, [&](size_t) {
+      FILE *file = fmemopen(&text[0], text.size(), "r");
+      StreamBuffer<FILE*, FN> in(file);
+      int value;
+      for (size_t i = 0; i < num_lines; i++) {
+        for (size_t j = 0; j < ints_per_line; j++) {
+          in.parseInt(value, i);
+          sink += value;
+        }
+        in.skipLine();
+      }
+      fclose(file);
+    });
+    bench("StreamBuffer::skipLine", num_lines, [&](size_t) {
+      FILE *file = fmemopen(&text[0], text.size(), "r");
+      StreamBuffer<FILE*, FN> in(file);
+      for (size_t i = 0; i < num_lines; i++) {
+        in.skipLine();
+      }
+      sink += *in;
+      fclose(file);
+    });
+    bench("StreamBuffer::parseString", num_ints, [&](size_t) {
+      FILE *file = fmemopen(&text[0], text.size(), "r");
+      StreamBuffer<FILE*, FN> in(file);
+      for (size_t i = 0; i < num_lines; i++) {
+        for (size_t j = 0; j < ints_per_line; j++) {
+          in.parseString(token);
+          sink += token.size();
+        }
+        in.skipLine();
+      }
+      fclose(file);
+    });
+  }
+}  // namespace
+
+int main() {
+  std::mt19937_64 rng(0);
+  bench_rational(&rng);
+  bench_chain_formula(&rng);
+  bench_bignum(&rng);
+  bench_parsing(&rng);
+  return 0;
+}
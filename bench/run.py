@@ -0,0 +1,82 @@
+import argparse
+import csv
+import os
+import subprocess
+import sys
+import time
+
+
+def jobs(args):
+    """Return the (tool, mode, command) to time on each input."""
+    return [
+        ("deweight", "default", [args.deweight]),
+        ("deweight", "dyadic", [args.deweight, "--dyadic=" + str(args.dyadic_bits)]),
+        ("dexor", "default", [args.dexor]),
+        ("weight", "random", [args.weight, "--seed=0", "--random=100"]),
+    ]
+
+
+def read_header(path):
+    """Return the number of variables and clauses declared by [path]."""
+    with open(path) as formula:
+        for line in formula:
+            if line.startswith("p "):
+                fields = line.split()
+                return int(fields[2]), int(fields[3])
+    return 0, 0
+
+
+def time_command(command, repeat):
+    """Return the best wall time over [repeat] runs, and the exit status."""
+    best = None
+    status = 0
+    for _ in range(repeat):
+        start = time.perf_counter()
+        with open(os.devnull, "w") as devnull:
+            status = subprocess.run(command, stdout=devnull, stderr=devnull).returncode
+        elapsed = time.perf_counter() - start
+        if best is None or elapsed < best:
+            best = elapsed
+    return best, status
+
+
+def run(args):
+    writer = csv.writer(args.csv)
+    writer.writerow(["input", "bytes", "vars", "clauses", "tool", "mode",
+                     "seconds", "mb_per_s", "vars_per_s", "status"])
+    for path in args.inputs:
+        size = os.path.getsize(path)
+        num_vars, num_clauses = read_header(path)
+        for tool, mode, command in jobs(args):
+            if not os.path.exists(command[0]):
+                log("Skipping %s (%s not built)" % (tool, command[0]))
+                continue
+            seconds, status = time_command(command + [path], args.repeat)
+            writer.writerow([os.path.basename(path), size, num_vars, num_clauses, tool, mode,
+                             "%.6f" % seconds,
+                             "%.2f" % (size / seconds / 1e6),
+                             "%.0f" % (num_vars / seconds),
+                             status])
+            args.csv.flush()
+            log("%s %s %s: %.3f s" % (os.path.basename(path), tool, mode, seconds))
+
+
+def log(line):
+    print(line, file=sys.stderr)
+    sys.stderr.flush()
+
+
+if __name__ == "__main__":
+    root = os.path.dirname(os.path.dirname(os.path.realpath(__file__)))
+    parser = argparse.ArgumentParser(description="Time deweight, dexor and weight on benchmark inputs.")
+    parser.add_argument("inputs", nargs="+", help="Weighted CNF files to run on.")
+    parser.add_argument("--deweight", type=str, help="Path to deweight.",
+                        default=os.path.join(root, "deweight/build/deweight"))
+    parser.add_argument("--dexor", type=str, help="Path to dexor.",
+                        default=os.path.join(root, "tools/dexor/build/dexor"))
+    parser.add_argument("--weight", type=str, help="Path to weight.",
+                        default=os.path.join(root, "tools/weight/build/weight"))
+    parser.add_argument("--dyadic-bits", type=int, help="Bits per weight for the dyadic reduction.", default=8)
+    parser.add_argument("--repeat", type=int, help="Runs of each command; the fastest is kept.", default=3)
+    parser.add_argument("--csv", type=argparse.FileType("w"), help="CSV file to write results to.", default=sys.stdout)
+    run(parser.parse_args())
@@ -0,0 +1,738 @@
+/******************************************
+Copyright (c) 2020, Jeffrey Dudek
+******************************************/
+
+#include "src/bignum.h"
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace deweight {
+  __extension__ typedef unsigned __int128 uint128;
+
+  // Product tree leaves handled by a single task when running in parallel
+  static const size_t kMinLeavesPerTask = 256;
+
+#ifndef USE_GMP
+  // Largest power of 10 that fits in a limb, and its number of digits
+  static const uint64_t kDecimalChunk = 10000000000000000000ULL;
+  static const int kDecimalChunkDigits = 19;
+
+  // Below this many limbs, schoolbook multiplication beats Karatsuba
+  static const size_t kKaratsubaThreshold = 32;
+
+  // Below this many limbs, repeated division by 10^19 beats splitting by
+  // larger powers of 10
+  static const size_t kDecimalThreshold = 64;
+
+  typedef std::vector<uint64_t> Limbs;
+
+  /**
+   * Add [src] into [out] starting at limb [offset], propagating the carry.
+   */
+  static void add_at(uint64_t *out, size_t out_size,
+                     const uint64_t *src, size_t src_size, size_t offset) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < src_size; i++) {
+      uint128 sum = static_cast<uint128>(out[offset + i]) + src[i] + carry;
+      out[offset + i] = static_cast<uint64_t>(sum);
+      carry = static_cast<uint64_t>(sum >> 64);
+    }
+    for (size_t i = offset + src_size; carry != 0 && i < out_size; i++) {
+      out[i] += 1;
+      carry = (out[i] == 0);
+    }
+  }
+
+  /**
+   * Subtract [y] from [x] in-place. Requires x >= y and x_size >= y_size.
+   */
+  static void sub_from(uint64_t *x, size_t x_size,
+                       const uint64_t *y, size_t y_size) {
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < x_size && (i < y_size || borrow != 0); i++) {
+      uint64_t sub = (i < y_size ? y[i] : 0);
+      uint64_t diff = x[i] - sub - borrow;
+      borrow = (x[i] < sub || (x[i] == sub && borrow != 0)) ? 1 : 0;
+      x[i] = diff;
+    }
+  }
+
+  /**
+   * Return the sum of [a] and [b] without leading zero limbs.
+   */
+  static std::vector<uint64_t> add(const uint64_t *a, size_t a_size,
+                                   const uint64_t *b, size_t b_size) {
+    if (a_size < b_size) {
+      std::swap(a, b);
+      std::swap(a_size, b_size);
+    }
+    std::vector<uint64_t> sum(a, a + a_size);
+    sum.push_back(0);
+    add_at(sum.data(), sum.size(), b, b_size, 0);
+    while (!sum.empty() && sum.back() == 0) {
+      sum.pop_back();
+    }
+    return sum;
+  }
+
+  /**
+   * Store the product of [a] and [b] in [out], which must have exactly
+   * a_size + b_size limbs and must not overlap the inputs.
+   */
+  static void multiply(const uint64_t *a, size_t a_size,
+                       const uint64_t *b, size_t b_size, uint64_t *out) {
+    if (a_size < b_size) {
+      std::swap(a, b);
+      std::swap(a_size, b_size);
+    }
+    std::fill(out, out + a_size + b_size, 0);
+    if (b_size == 0) {
+      return;
+    }
+
+    if (b_size < kKaratsubaThreshold) {
+      // Schoolbook multiplication
+      for (size_t i = 0; i < b_size; i++) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < a_size; j++) {
+          uint128 product = static_cast<uint128>(a[j]) * b[i]
+                            + out[i + j] + carry;
+          out[i + j] = static_cast<uint64_t>(product);
+          carry = static_cast<uint64_t>(product >> 64);
+        }
+        out[i + a_size] = carry;
+      }
+      return;
+    }
+
+    if (a_size >= 2 * b_size) {
+      // Unbalanced sizes; multiply [b] by each b_size-limb slice of [a]
+      std::vector<uint64_t> partial(2 * b_size);
+      for (size_t i = 0; i < a_size; i += b_size) {
+        size_t len = std::min(b_size, a_size - i);
+        multiply(a + i, len, b, b_size, partial.data());
+        add_at(out, a_size + b_size, partial.data(), len + b_size, i);
+      }
+      return;
+    }
+
+    // Karatsuba: split both at limb [half] (b_size > half, so b_hi is nonempty)
+    size_t half = a_size / 2;
+    std::vector<uint64_t> low(2 * half);
+    multiply(a, half, b, half, low.data());
+    std::vector<uint64_t> high(a_size + b_size - 2 * half);
+    multiply(a + half, a_size - half, b + half, b_size - half, high.data());
+
+    std::vector<uint64_t> a_sum = add(a, half, a + half, a_size - half);
+    std::vector<uint64_t> b_sum = add(b, half, b + half, b_size - half);
+    std::vector<uint64_t> mid(a_sum.size() + b_sum.size());
+    multiply(a_sum.data(), a_sum.size(), b_sum.data(), b_sum.size(),
+             mid.data());
+    sub_from(mid.data(), mid.size(), low.data(), low.size());
+    sub_from(mid.data(), mid.size(), high.data(), high.size());
+    while (!mid.empty() && mid.back() == 0) {
+      mid.pop_back();
+    }
+
+    std::copy(low.begin(), low.end(), out);
+    std::copy(high.begin(), high.end(), out + 2 * half);
+    add_at(out, a_size + b_size, mid.data(), mid.size(), half);
+  }
+
+  BigNum& BigNum::operator*=(uint64_t factor) {
+    if (factor == 0) {
+      limbs_.clear();
+      return *this;
+    }
+    uint64_t carry = 0;
+    for (uint64_t &limb : limbs_) {
+      uint128 product = static_cast<uint128>(limb) * factor + carry;
+      limb = static_cast<uint64_t>(product);
+      carry = static_cast<uint64_t>(product >> 64);
+    }
+    if (carry != 0) {
+      limbs_.push_back(carry);
+    }
+    return *this;
+  }
+
+  BigNum& BigNum::operator*=(const BigNum& other) {
+    std::vector<uint64_t> result(limbs_.size() + other.limbs_.size());
+    multiply(limbs_.data(), limbs_.size(),
+             other.limbs_.data(), other.limbs_.size(), result.data());
+    while (!result.empty() && result.back() == 0) {
+      result.pop_back();
+    }
+    limbs_.swap(result);
+    return *this;
+  }
+
+  /**
+   * Remove leading zero limbs from [x].
+   */
+  static void trim(Limbs *x) {
+    while (!x->empty() && x->back() == 0) {
+      x->pop_back();
+    }
+  }
+
+  /**
+   * Compare [a] and [b], neither of which has leading zero limbs.
+   */
+  static int compare(const Limbs &a, const Limbs &b) {
+    if (a.size() != b.size()) {
+      return a.size() < b.size() ? -1 : 1;
+    }
+    for (size_t i = a.size(); i-- > 0;) {
+      if (a[i] != b[i]) {
+        return a[i] < b[i] ? -1 : 1;
+      }
+    }
+    return 0;
+  }
+
+  static Limbs mul(const Limbs &a, const Limbs &b) {
+    Limbs result(a.size() + b.size());
+    multiply(a.data(), a.size(), b.data(), b.size(), result.data());
+    trim(&result);
+    return result;
+  }
+
+  /**
+   * Subtract [b] from [a] in-place. Requires a >= b.
+   */
+  static void subtract(Limbs *a, const Limbs &b) {
+    sub_from(a->data(), a->size(), b.data(), b.size());
+    trim(a);
+  }
+
+  static void increase(Limbs *a, const Limbs &b) {
+    *a = add(a->data(), a->size(), b.data(), b.size());
+  }
+
+  /**
+   * Return [x] divided by B^[limbs], rounding down (where B = 2^64).
+   */
+  static Limbs shift_down(const Limbs &x, size_t limbs) {
+    if (limbs >= x.size()) {
+      return Limbs();
+    }
+    return Limbs(x.begin() + limbs, x.end());
+  }
+
+  /**
+   * Return floor(B^2n / m) for the n-limb number [m] (where B = 2^64).
+   *
+   * Starts from the reciprocal of the top half of [m] and applies Newton's
+   * iteration, so this costs a few multiplications of n limbs.
+   */
+  static Limbs reciprocal(const Limbs &m) {
+    size_t n = m.size();
+    Limbs power(2 * n, 0);
+    power.push_back(1);
+
+    Limbs x;
+    if (n == 1) {
+      if (m[0] == 1) {
+        return power;
+      }
+      uint128 approx = ~static_cast<uint128>(0) / m[0];
+      x = {static_cast<uint64_t>(approx), static_cast<uint64_t>(approx >> 64)};
+      trim(&x);
+    } else {
+      size_t half = (n + 1) / 2;
+      x = reciprocal(shift_down(m, n - half));
+      x.insert(x.begin(), n - half, 0);
+    }
+
+    for (;;) {
+      Limbs product = mul(m, x);
+      if (compare(product, power) > 0) {
+        // Too large: x -= x * (mx - B^2n) / B^2n, rounding up
+        subtract(&product, power);
+        Limbs step = shift_down(mul(x, product), 2 * n);
+        increase(&step, Limbs(1, 1));
+        subtract(&x, step);
+        continue;
+      }
+      Limbs error = power;
+      subtract(&error, product);
+      if (compare(error, m) < 0) {
+        return x;
+      }
+      // Too small: x += x * (B^2n - mx) / B^2n, by at least 1
+      Limbs step = shift_down(mul(x, error), 2 * n);
+      if (step.empty()) {
+        step.push_back(1);
+      }
+      increase(&x, step);
+    }
+  }
+
+  /**
+   * 10^[digits], with its reciprocal for dividing by it.
+   */
+  struct DecimalPower {
+    Limbs value;
+    Limbs inverse;
+    size_t digits;
+  };
+
+  /**
+   * Split [x] < power^2 into the quotient and remainder by [power].
+   */
+  static void divide(const Limbs &x, const DecimalPower &power,
+                     Limbs *quotient, Limbs *remainder) {
+    // Barrett reduction; the estimate is at most 2 too small
+    size_t n = power.value.size();
+    *quotient = shift_down(mul(shift_down(x, n - 1), power.inverse), n + 1);
+    *remainder = x;
+    subtract(remainder, mul(*quotient, power.value));
+    while (compare(*remainder, power.value) >= 0) {
+      subtract(remainder, power.value);
+      increase(quotient, Limbs(1, 1));
+    }
+  }
+
+  /**
+   * Write [x] as exactly [width] decimal digits (with leading zeros) to
+   * [out], by repeatedly dividing by 10^19. Requires x < 10^width.
+   */
+  static void write_digits(Limbs x, char *out, size_t width) {
+    char *end = out + width;
+    while (!x.empty()) {
+      uint64_t remainder = 0;
+      for (size_t i = x.size(); i-- > 0;) {
+        uint128 current = (static_cast<uint128>(remainder) << 64) | x[i];
+        x[i] = static_cast<uint64_t>(current / kDecimalChunk);
+        remainder = static_cast<uint64_t>(current % kDecimalChunk);
+      }
+      trim(&x);
+      for (int d = 0; d < kDecimalChunkDigits && end > out; d++) {
+        *--end = static_cast<char>('0' + remainder % 10);
+        remainder /= 10;
+      }
+    }
+    std::fill(out, end, '0');
+  }
+
+  /**
+   * Write [x] < powers[level]^2 as exactly 2 * powers[level].digits decimal
+   * digits to [out], splitting it by powers of 10 until the parts are small.
+   */
+  static void write_digits(const Limbs &x,
+                           const std::vector<DecimalPower> &powers,
+                           size_t level, char *out) {
+    const DecimalPower &power = powers[level];
+    if (level == 0 || x.size() <= kDecimalThreshold) {
+      write_digits(x, out, 2 * power.digits);
+      return;
+    }
+    Limbs quotient, remainder;
+    divide(x, power, &quotient, &remainder);
+    write_digits(quotient, powers, level - 1, out);
+    write_digits(remainder, powers, level - 1, out + power.digits);
+  }
+
+  std::string BigNum::to_string(ThreadPool *pool) const {
+    if (limbs_.empty()) {
+      return "0";
+    }
+    if (limbs_.size() <= kDecimalThreshold) {
+      // Each limb is less than 10^20
+      std::string result(limbs_.size() * 20, '0');
+      write_digits(limbs_, &result[0], result.size());
+      return result.substr(result.find_first_not_of('0'));
+    }
+
+    // Square 10^19 until the square of the largest power exceeds the number
+    std::vector<DecimalPower> powers;
+    powers.push_back({Limbs(1, kDecimalChunk), Limbs(),
+                      static_cast<size_t>(kDecimalChunkDigits)});
+    while (2 * (powers.back().value.size() - 1) < limbs_.size()) {
+      const DecimalPower &last = powers.back();
+      powers.push_back({mul(last.value, last.value), Limbs(),
+                        2 * last.digits});
+    }
+
+    // Reciprocals are independent of each other
+    std::vector<std::future<void>> pending;
+    for (DecimalPower &power : powers) {
+      Limbs *inverse = &power.inverse;
+      const Limbs *value = &power.value;
+      if (pool == nullptr) {
+        *inverse = reciprocal(*value);
+      } else {
+        pending.push_back(pool->submit([inverse, value]() {
+          *inverse = reciprocal(*value);
+        }));
+      }
+    }
+    for (auto &result : pending) {
+      result.get();
+    }
+
+    // Split into parts level by level until there is one per thread; each
+    // part at [level] fills 2 * powers[level].digits digits of the result
+    size_t level = powers.size() - 1;
+    std::vector<Limbs> parts(1, limbs_);
+    size_t num_threads = pool == nullptr ? 1 : pool->size();
+    while (parts.size() < num_threads && level > 0
+           && parts[0].size() > kDecimalThreshold) {
+      std::vector<Limbs> next(2 * parts.size());
+      std::vector<std::future<void>> splits;
+      for (size_t i = 0; i < parts.size(); i++) {
+        const DecimalPower *power = &powers[level];
+        const Limbs *part = &parts[i];
+        Limbs *quotient = &next[2 * i];
+        Limbs *remainder = &next[2 * i + 1];
+        splits.push_back(pool->submit([part, power, quotient, remainder]() {
+          deweight::divide(*part, *power, quotient, remainder);
+        }));
+      }
+      for (auto &result : splits) {
+        result.get();
+      }
+      parts.swap(next);
+      level--;
+    }
+
+    size_t width = 2 * powers[level].digits;
+    std::string result(parts.size() * width, '0');
+    std::vector<std::future<void>> writes;
+    for (size_t i = 0; i < parts.size(); i++) {
+      auto write = [&parts, &powers, &result, level, width, i]() {
+        write_digits(parts[i], powers, level, &result[i * width]);
+      };
+      if (pool == nullptr) {
+        write();
+      } else {
+        writes.push_back(pool->submit(write));
+      }
+    }
+    for (auto &result : writes) {
+      result.get();
+    }
+    return result.substr(result.find_first_not_of('0'));
+  }
+
+  BigNum BigNum::parse(const std::string &digits) {
+    // Take the digits 19 at a time, starting with the leftover ones
+    BigNum result;
+    size_t end = digits.size() % kDecimalChunkDigits;
+    if (end == 0) {
+      end = kDecimalChunkDigits;
+    }
+    for (size_t begin = 0; begin < digits.size();
+         begin = end, end += kDecimalChunkDigits) {
+      uint64_t chunk = 0;
+      uint64_t scale = 1;
+      for (size_t i = begin; i < end; i++) {
+        chunk = chunk * 10 + static_cast<uint64_t>(digits[i] - '0');
+        scale *= 10;
+      }
+      result *= scale;
+      result += BigNum(chunk);
+    }
+    return result;
+  }
+
+  BigNum& BigNum::operator+=(const BigNum& other) {
+    increase(&limbs_, other.limbs_);
+    return *this;
+  }
+
+  BigNum& BigNum::operator-=(const BigNum& other) {
+    subtract(&limbs_, other.limbs_);
+    return *this;
+  }
+
+  uint64_t BigNum::divide(uint64_t divisor) {
+    uint64_t remainder = 0;
+    for (size_t i = limbs_.size(); i-- > 0;) {
+      uint128 current = (static_cast<uint128>(remainder) << 64) | limbs_[i];
+      limbs_[i] = static_cast<uint64_t>(current / divisor);
+      remainder = static_cast<uint64_t>(current % divisor);
+    }
+    trim(&limbs_);
+    return remainder;
+  }
+
+  BigNum BigNum::divide(const BigNum& divisor) {
+    const Limbs &d = divisor.limbs_;
+    BigNum remainder;
+    if (deweight::compare(limbs_, d) < 0) {
+      remainder.limbs_.swap(limbs_);
+      return remainder;
+    } else if (d.size() == 1) {
+      return BigNum(divide(d[0]));
+    }
+
+    // Knuth's algorithm D: shift so the top limb of the divisor has its
+    // high bit set, then find one quotient limb at a time
+    size_t n = d.size();
+    size_t m = limbs_.size() - n;
+    int shift = __builtin_clzll(d.back());
+    Limbs v(d);
+    Limbs u(limbs_);
+    u.push_back(0);
+    if (shift > 0) {
+      for (size_t i = u.size() - 1; i > 0; i--) {
+        u[i] = (u[i] << shift) | (u[i - 1] >> (64 - shift));
+      }
+      u[0] <<= shift;
+      for (size_t i = n - 1; i > 0; i--) {
+        v[i] = (v[i] << shift) | (v[i - 1] >> (64 - shift));
+      }
+      v[0] <<= shift;
+    }
+
+    Limbs quotient(m + 1);
+    for (size_t j = m + 1; j-- > 0;) {
+      // Estimate from the top two limbs; this is at most 2 too large
+      uint128 top = (static_cast<uint128>(u[j + n]) << 64) | u[j + n - 1];
+      uint128 qhat = top / v[n - 1];
+      uint128 rhat = top % v[n - 1];
+      while ((qhat >> 64) != 0
+             || qhat * v[n - 2] > ((rhat << 64) | u[j + n - 2])) {
+        qhat--;
+        rhat += v[n - 1];
+        if ((rhat >> 64) != 0) {
+          break;
+        }
+      }
+
+      // Subtract qhat * v, adding v back if that went below zero
+      uint128 borrow = 0;
+      for (size_t i = 0; i < n; i++) {
+        uint128 product = qhat * v[i] + borrow;
+        uint64_t low = static_cast<uint64_t>(product);
+        borrow = (product >> 64) + (u[i + j] < low ? 1 : 0);
+        u[i + j] -= low;
+      }
+      bool negative = u[j + n] < borrow;
+      u[j + n] -= static_cast<uint64_t>(borrow);
+      if (negative) {
+        qhat--;
+        uint64_t carry = 0;
+        for (size_t i = 0; i < n; i++) {
+          uint128 sum = static_cast<uint128>(u[i + j]) + v[i] + carry;
+          u[i + j] = static_cast<uint64_t>(sum);
+          carry = static_cast<uint64_t>(sum >> 64);
+        }
+        u[j + n] += carry;
+      }
+      quotient[j] = static_cast<uint64_t>(qhat);
+    }
+
+    u.resize(n);
+    if (shift > 0) {
+      for (size_t i = 0; i + 1 < n; i++) {
+        u[i] = (u[i] >> shift) | (u[i + 1] << (64 - shift));
+      }
+      u[n - 1] >>= shift;
+    }
+    trim(&u);
+    trim(&quotient);
+    limbs_.swap(quotient);
+    remainder.limbs_.swap(u);
+    return remainder;
+  }
+
+  int BigNum::compare(const BigNum& other) const {
+    return deweight::compare(limbs_, other.limbs_);
+  }
+
+  size_t BigNum::bit_length() const {
+    if (limbs_.empty()) {
+      return 0;
+    }
+    return 64 * limbs_.size() - __builtin_clzll(limbs_.back());
+  }
+
+  bool BigNum::test_bit(size_t bit) const {
+    return bit / 64 < limbs_.size() && ((limbs_[bit / 64] >> (bit % 64)) & 1);
+  }
+
+  uint64_t BigNum::to_uint64() const {
+    return limbs_.empty() ? 0 : limbs_[0];
+  }
+
+  double BigNum::log2() const {
+    // The top two limbs are more than a double can hold
+    size_t size = limbs_.size();
+    double top = static_cast<double>(limbs_.back());
+    if (size > 1) {
+      top = std::ldexp(top, 64) + static_cast<double>(limbs_[size - 2]);
+      return std::log2(top) + 64.0 * static_cast<double>(size - 2);
+    }
+    return std::log2(top);
+  }
+
+#else
+  BigNum BigNum::parse(const std::string &digits) {
+    BigNum result;
+    result.value_.set_str(digits, 10);
+    return result;
+  }
+
+  BigNum& BigNum::operator+=(const BigNum& other) {
+    value_ += other.value_;
+    return *this;
+  }
+
+  BigNum& BigNum::operator-=(const BigNum& other) {
+    value_ -= other.value_;
+    return *this;
+  }
+
+  uint64_t BigNum::divide(uint64_t divisor) {
+    return mpz_fdiv_q_ui(value_.get_mpz_t(), value_.get_mpz_t(), divisor);
+  }
+
+  BigNum BigNum::divide(const BigNum& divisor) {
+    BigNum remainder;
+    mpz_fdiv_qr(value_.get_mpz_t(), remainder.value_.get_mpz_t(),
+                value_.get_mpz_t(), divisor.value_.get_mpz_t());
+    return remainder;
+  }
+
+  int BigNum::compare(const BigNum& other) const {
+    int result = cmp(value_, other.value_);
+    return (result > 0) - (result < 0);
+  }
+
+  size_t BigNum::bit_length() const {
+    return is_zero() ? 0 : mpz_sizeinbase(value_.get_mpz_t(), 2);
+  }
+
+  bool BigNum::test_bit(size_t bit) const {
+    return mpz_tstbit(value_.get_mpz_t(), bit) != 0;
+  }
+
+  uint64_t BigNum::to_uint64() const {
+    return mpz_get_ui(value_.get_mpz_t());
+  }
+
+  double BigNum::log2() const {
+    long exponent;
+    double mantissa = mpz_get_d_2exp(&exponent, value_.get_mpz_t());
+    return std::log2(mantissa) + static_cast<double>(exponent);
+  }
+
+  BigNum& BigNum::operator*=(uint64_t factor) {
+    mpz_mul_ui(value_.get_mpz_t(), value_.get_mpz_t(), factor);
+    return *this;
+  }
+
+  BigNum& BigNum::operator*=(const BigNum& other) {
+    value_ *= other.value_;
+    return *this;
+  }
+
+  std::string BigNum::to_string(ThreadPool *) const {
+    return value_.get_str();
+  }
+#endif  // USE_GMP
+
+  BigNum gcd(BigNum a, BigNum b) {
+#ifdef USE_GMP
+    BigNum result;
+    mpz_gcd(result.value_.get_mpz_t(), a.value_.get_mpz_t(),
+            b.value_.get_mpz_t());
+    return result;
+#else
+    while (!b.is_zero()) {
+      BigNum remainder = a.divide(b);
+      a = std::move(b);
+      b = std::move(remainder);
+    }
+    return a;
+#endif
+  }
+
+  /**
+   * Multiply together leaves[begin, end) with a balanced product tree.
+   */
+  static BigNum product_tree(const std::vector<BigNum> &leaves,
+                             size_t begin, size_t end) {
+    if (begin == end) {
+      return BigNum(1);
+    } else if (end - begin == 1) {
+      return leaves[begin];
+    }
+    size_t mid = begin + (end - begin) / 2;
+    BigNum result = product_tree(leaves, begin, mid);
+    result *= product_tree(leaves, mid, end);
+    return result;
+  }
+
+  BigNum BigNum::product(const std::vector<uint64_t> &factors,
+                         ThreadPool *pool) {
+    // Pack runs of small factors into single-limb leaves
+    std::vector<BigNum> leaves;
+    uint64_t packed = 1;
+    for (uint64_t factor : factors) {
+      uint128 next = static_cast<uint128>(packed) * factor;
+      if ((next >> 64) != 0) {
+        leaves.push_back(BigNum(packed));
+        packed = factor;
+      } else {
+        packed = static_cast<uint64_t>(next);
+      }
+    }
+    leaves.push_back(BigNum(packed));
+
+    size_t num_tasks = 1;
+    if (pool != nullptr) {
+      num_tasks = std::min(pool->size(), leaves.size() / kMinLeavesPerTask);
+    }
+    if (num_tasks <= 1) {
+      return product_tree(leaves, 0, leaves.size());
+    }
+
+    // Compute the bottom of the tree as one subtree per task ...
+    std::vector<std::future<BigNum>> pending;
+    for (size_t i = 0; i < num_tasks; i++) {
+      size_t begin = leaves.size() * i / num_tasks;
+      size_t end = leaves.size() * (i + 1) / num_tasks;
+      pending.push_back(pool->submit([&leaves, begin, end]() {
+        return product_tree(leaves, begin, end);
+      }));
+    }
+    std::vector<BigNum> level;
+    for (auto &result : pending) {
+      level.push_back(result.get());
+    }
+
+    // ... then multiply adjacent subtrees in parallel until one remains
+    while (level.size() > 1) {
+      std::vector<std::future<BigNum>> pairs;
+      for (size_t i = 0; i + 1 < level.size(); i += 2) {
+        pairs.push_back(pool->submit([&level, i]() {
+          BigNum result = level[i];
+          result *= level[i + 1];
+          return result;
+        }));
+      }
+      std::vector<BigNum> next;
+      for (auto &result : pairs) {
+        next.push_back(result.get());
+      }
+      if (level.size() % 2 == 1) {
+        next.push_back(std::move(level.back()));
+      }
+      level.swap(next);
+    }
+    return level[0];
+  }
+
+  std::ostream& operator<<(std::ostream& os, const BigNum& num) {
+    return os << num.to_string();
+  }
+}  // namespace deweight
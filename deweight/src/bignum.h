@@ -0,0 +1,168 @@
+/******************************************
+Copyright (c) 2020, Jeffrey Dudek
+******************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef USE_GMP
+#include <gmpxx.h>
+#endif
+
+#include "src/thread_pool.h"
+
+namespace deweight {
+/**
+ * Represents an arbitrarily large natural number in binary.
+ *
+ * The value is stored as little-endian 64-bit limbs, so multiplying by a
+ * machine word is a single pass over the limbs. Conversion to decimal only
+ * happens when the number is printed.
+ *
+ * Built with USE_GMP, the value is a GMP integer instead.
+ */
+class BigNum {
+ public:
+  BigNum() {}
+  BigNum(const BigNum& other) = default;
+  BigNum& operator=(const BigNum& other) = default;
+  BigNum(BigNum&& other) = default;
+  BigNum& operator=(BigNum&& other) = default;
+
+#ifdef USE_GMP
+  BigNum(uint64_t value) {
+    mpz_set_ui(value_.get_mpz_t(), value);
+  }
+#else
+  BigNum(uint64_t value) {
+    if (value != 0) {
+      limbs_.push_back(value);
+    }
+  }
+#endif
+
+  /**
+   * Parse a nonempty string of decimal [digits].
+   */
+  static BigNum parse(const std::string &digits);
+
+  /**
+   * Add [other] to this number in-place.
+   */
+  BigNum& operator+=(const BigNum& other);
+
+  /**
+   * Subtract [other] from this number in-place. Requires this >= [other].
+   */
+  BigNum& operator-=(const BigNum& other);
+
+  /**
+   * Multiply this number in-place by a single word.
+   */
+  BigNum& operator*=(uint64_t factor);
+
+  /**
+   * Multiply this number in-place by another number.
+   */
+  BigNum& operator*=(const BigNum& other);
+
+  /**
+   * Compute the product of all [factors] with a balanced product tree.
+   *
+   * Subtrees are multiplied in parallel on [pool] (if provided).
+   */
+  static BigNum product(const std::vector<uint64_t> &factors,
+                        ThreadPool *pool = nullptr);
+
+  /**
+   * Divide this number in-place by the nonzero [divisor], rounding down, and
+   * return the remainder.
+   */
+  uint64_t divide(uint64_t divisor);
+
+  /**
+   * Divide this number in-place by the nonzero [divisor], rounding down, and
+   * return the remainder.
+   */
+  BigNum divide(const BigNum& divisor);
+
+  /**
+   * Return -1, 0 or 1 as this number is less than, equal to or greater than
+   * [other].
+   */
+  int compare(const BigNum& other) const;
+
+  bool operator==(const BigNum& other) const { return compare(other) == 0; }
+  bool operator!=(const BigNum& other) const { return compare(other) != 0; }
+  bool operator<(const BigNum& other) const { return compare(other) < 0; }
+
+  /**
+   * Get the number of bits up to the highest 1 bit (0 for zero).
+   */
+  size_t bit_length() const;
+
+  /**
+   * Return true if bit [bit] (counting from the least significant) is 1.
+   */
+  bool test_bit(size_t bit) const;
+
+  /**
+   * Get the value, which must be less than 2^64.
+   */
+  uint64_t to_uint64() const;
+
+  /**
+   * Get the base-2 logarithm of this nonzero number.
+   */
+  double log2() const;
+
+#ifdef USE_GMP
+  bool is_zero() const { return sgn(value_) == 0; }
+
+  /**
+   * Get the number of 64-bit limbs used to store this number.
+   */
+  size_t num_limbs() const { return mpz_size(value_.get_mpz_t()); }
+#else
+  bool is_zero() const { return limbs_.empty(); }
+
+  /**
+   * Get the number of 64-bit limbs used to store this number.
+   */
+  size_t num_limbs() const { return limbs_.size(); }
+#endif
+
+  /**
+   * Get the decimal representation of this number.
+   *
+   * Large numbers are split by powers of 10 into parts that are converted
+   * in parallel on [pool] (if provided). GMP converts on one thread.
+   */
+  std::string to_string(ThreadPool *pool = nullptr) const;
+
+ private:
+  friend BigNum gcd(BigNum a, BigNum b);
+
+#ifdef USE_GMP
+  mpz_class value_;
+#else
+  // Little-endian limbs, without leading zero limbs
+  std::vector<uint64_t> limbs_;
+#endif
+};
+
+std::ostream& operator<<(std::ostream& os, const BigNum& num);
+
+/**
+ * Greatest common divisor of [a] and [b].
+ */
+BigNum gcd(BigNum a, BigNum b);
+
+inline std::string to_string(const BigNum& num) {
+  return num.to_string();
+}
+}  // namespace deweight
@@ -0,0 +1,328 @@
+/******************************************
+Copyright (c) 2020, Jeffrey Dudek
+******************************************/
+
+#include "src/denominator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include "src/rational.h"
+
+namespace deweight {
+  // Factors below this are found by trial division; the rest of the value
+  // is split by Pollard's rho
+  static const uint64_t kTrialLimit = 1 << 10;
+
+  static uint64_t mul_mod(uint64_t a, uint64_t b, uint64_t modulus) {
+    return static_cast<uint64_t>(static_cast<uint128>(a) * b % modulus);
+  }
+
+  static uint64_t pow_mod(uint64_t base, uint64_t exponent, uint64_t modulus) {
+    uint64_t result = 1;
+    base %= modulus;
+    while (exponent > 0) {
+      if (exponent & 1) {
+        result = mul_mod(result, base, modulus);
+      }
+      base = mul_mod(base, base, modulus);
+      exponent >>= 1;
+    }
+    return result;
+  }
+
+  /**
+   * Return true if [value] is prime, by a Miller-Rabin test with bases that
+   * make it exact for all 64-bit values.
+   */
+  static bool is_prime(uint64_t value) {
+    static const uint64_t kBases[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31,
+                                      37};
+    if (value < 2) {
+      return false;
+    }
+    for (uint64_t base : kBases) {
+      if (value % base == 0) {
+        return value == base;
+      }
+    }
+    uint64_t odd = value - 1;
+    int twos = 0;
+    while ((odd & 1) == 0) {
+      odd >>= 1;
+      twos++;
+    }
+    for (uint64_t base : kBases) {
+      uint64_t x = pow_mod(base, odd, value);
+      if (x == 1 || x == value - 1) {
+        continue;
+      }
+      bool witness = true;
+      for (int i = 1; i < twos && witness; i++) {
+        x = mul_mod(x, x, value);
+        witness = x != value - 1;
+      }
+      if (witness) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static BigNum mul_mod(const BigNum &a, const BigNum &b,
+                        const BigNum &modulus) {
+    BigNum product = a;
+    product *= b;
+    return product.divide(modulus);
+  }
+
+  /**
+   * Return true if [value], which is over 64 bits and has no factors below
+   * kTrialLimit, is prime with high probability, by a Miller-Rabin test
+   * with the same bases as for 64-bit values.
+   */
+  static bool is_probable_prime(const BigNum &value) {
+    static const uint64_t kBases[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31,
+                                      37};
+    BigNum less = value;
+    less -= BigNum(1);
+    size_t twos = 0;
+    while (!less.test_bit(twos)) {
+      twos++;
+    }
+    BigNum odd = less;
+    for (size_t shifted = 0; shifted < twos; shifted += 32) {
+      odd.divide(static_cast<uint64_t>(1) << std::min<size_t>(32,
+                                                              twos - shifted));
+    }
+
+    for (uint64_t base : kBases) {
+      BigNum x(1);
+      BigNum power(base);
+      for (size_t bit = 0; bit < odd.bit_length(); bit++) {
+        if (odd.test_bit(bit)) {
+          x = mul_mod(x, power, value);
+        }
+        power = mul_mod(power, power, value);
+      }
+      if (x == BigNum(1) || x == less) {
+        continue;
+      }
+      bool witness = true;
+      for (size_t i = 1; i < twos && witness; i++) {
+        x = mul_mod(x, x, value);
+        witness = x != less;
+      }
+      if (witness) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Find a nontrivial factor of the odd composite [value] by Pollard's rho.
+   */
+  static uint64_t find_factor(uint64_t value) {
+    for (uint64_t c = 1;; c++) {
+      auto step = [value, c](uint64_t x) {
+        return static_cast<uint64_t>(
+          (static_cast<uint128>(x) * x + c) % value);
+      };
+      uint64_t slow = 2;
+      uint64_t fast = 2;
+      uint64_t divisor = 1;
+      while (divisor == 1) {
+        slow = step(slow);
+        fast = step(step(fast));
+        divisor = std::__gcd(slow > fast ? slow - fast : fast - slow, value);
+      }
+      if (divisor != value) {
+        return divisor;
+      }
+    }
+  }
+
+  /**
+   * Append the prime factors of [value], which has none below kTrialLimit,
+   * to [primes] (with repetition).
+   */
+  static void split(uint64_t value, std::vector<uint64_t> *primes) {
+    if (value == 1) {
+      return;
+    }
+    if (is_prime(value)) {
+      primes->push_back(value);
+      return;
+    }
+    uint64_t divisor = find_factor(value);
+    split(divisor, primes);
+    split(value / divisor, primes);
+  }
+
+  /**
+   * Factor [value] into primes.
+   */
+  static std::vector<std::pair<uint64_t, int>> factorize(uint64_t value) {
+    std::vector<std::pair<uint64_t, int>> result;
+    for (uint64_t p = 2; p < kTrialLimit && p * p <= value;
+         p += (p == 2 ? 1 : 2)) {
+      int exponent = 0;
+      while (value % p == 0) {
+        value /= p;
+        exponent++;
+      }
+      if (exponent > 0) {
+        result.emplace_back(p, exponent);
+      }
+    }
+
+    std::vector<uint64_t> primes;
+    split(value, &primes);
+    std::sort(primes.begin(), primes.end());
+    for (uint64_t prime : primes) {
+      if (!result.empty() && result.back().first == prime) {
+        result.back().second++;
+      } else {
+        result.emplace_back(prime, 1);
+      }
+    }
+    return result;
+  }
+
+  void Denominator::multiply(uint64_t factor) {
+    if (!factored_) {
+      factors_.push_back(factor);
+      return;
+    }
+
+    if (factor == 0) {
+      // Keep a zero denominator visible rather than factoring it
+      exponents_[0] += 1;
+      return;
+    }
+    auto cached = factorizations_.find(factor);
+    if (cached == factorizations_.end()) {
+      cached = factorizations_.emplace(factor, factorize(factor)).first;
+    }
+    for (const auto &prime_power : cached->second) {
+      exponents_[prime_power.first] += prime_power.second;
+    }
+  }
+
+  void Denominator::multiply(const BigNum &factor) {
+    if (!factored_) {
+      big_factors_.push_back(factor);
+      return;
+    }
+
+    if (factor.is_zero()) {
+      exponents_[0] += 1;
+      return;
+    }
+    // Take out the small primes, then factor what is left if it fits
+    BigNum rest = factor;
+    for (uint64_t p = 2; p < kTrialLimit && rest.bit_length() > 64;
+         p += (p == 2 ? 1 : 2)) {
+      BigNum quotient = rest;
+      while (quotient.divide(p) == 0) {
+        exponents_[p] += 1;
+        rest = quotient;
+      }
+    }
+    // Take out the primes over 64 bits seen so far
+    for (auto &power : big_exponents_) {
+      if (rest.bit_length() <= 64) {
+        break;
+      }
+      BigNum quotient = rest;
+      while (quotient.divide(power.first).is_zero()) {
+        power.second += 1;
+        rest = quotient;
+      }
+    }
+    if (rest.bit_length() <= 64) {
+      multiply(rest.to_uint64());
+    } else if (is_probable_prime(rest)) {
+      big_exponents_[rest] += 1;
+    } else {
+      cofactors_[rest] += 1;
+    }
+  }
+
+  BigNum Denominator::value(ThreadPool *pool) const {
+    BigNum result = BigNum::product(factors_, pool);
+    for (const BigNum &factor : big_factors_) {
+      result *= factor;
+    }
+    return result;
+  }
+
+  std::string Denominator::factors() const {
+    std::string result;
+    for (const auto &prime_power : exponents_) {
+      if (!result.empty()) {
+        result.push_back(' ');
+      }
+      result.append(std::to_string(prime_power.first));
+      result.push_back('^');
+      result.append(std::to_string(prime_power.second));
+    }
+    // Each is over 64 bits, so larger than the primes above
+    for (const auto &power : big_exponents_) {
+      if (!result.empty()) {
+        result.push_back(' ');
+      }
+      result.append(power.first.to_string());
+      result.push_back('^');
+      result.append(std::to_string(power.second));
+    }
+    // Composite parts that were not split follow a '*'
+    for (const auto &power : cofactors_) {
+      result.append(result.empty() ? "* " : " * ");
+      result.append(power.first.to_string());
+      result.push_back('^');
+      result.append(std::to_string(power.second));
+    }
+    return result;
+  }
+
+  double Denominator::log2() const {
+    double result = 0;
+    for (const auto &prime_power : exponents_) {
+      result += std::log2(static_cast<double>(prime_power.first))
+                * static_cast<double>(prime_power.second);
+    }
+    for (const auto &powers : {&big_exponents_, &cofactors_}) {
+      for (const auto &power : *powers) {
+        result += power.first.log2() * static_cast<double>(power.second);
+      }
+    }
+    return result;
+  }
+
+  size_t Denominator::memory_usage() const {
+    // Tree and hash nodes carry a few pointers besides their value
+    const size_t node_overhead = 4 * sizeof(void *);
+    size_t bytes = factors_.capacity() * sizeof(uint64_t);
+    for (const BigNum &factor : big_factors_) {
+      bytes += sizeof(BigNum) + factor.num_limbs() * sizeof(uint64_t);
+    }
+    for (const auto &powers : {&big_exponents_, &cofactors_}) {
+      for (const auto &power : *powers) {
+        bytes += sizeof(power) + node_overhead
+                 + power.first.num_limbs() * sizeof(uint64_t);
+      }
+    }
+    bytes += exponents_.size()
+             * (sizeof(std::pair<const uint64_t, uint64_t>) + node_overhead);
+    bytes += factorizations_.bucket_count() * sizeof(void *);
+    for (const auto &factorization : factorizations_) {
+      bytes += sizeof(factorization) + node_overhead
+               + factorization.second.capacity()
+                 * sizeof(std::pair<uint64_t, int>);
+    }
+    return bytes;
+  }
+}  // namespace deweight
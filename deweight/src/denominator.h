@@ -0,0 +1,83 @@
+/******************************************
+Copyright (c) 2020, Jeffrey Dudek
+******************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "src/bignum.h"
+#include "src/thread_pool.h"
+
+namespace deweight {
+/**
+ * Accumulates the normalizing denominator of a reduction.
+ *
+ * In expanded mode the factors are recorded and multiplied once at the end.
+ * In factored mode only a map of prime -> exponent is kept, so the full
+ * product is never computed.
+ */
+class Denominator {
+ public:
+  explicit Denominator(bool factored) : factored_(factored) {}
+
+  /**
+   * Multiply the denominator by [factor].
+   */
+  void multiply(uint64_t factor);
+
+  /**
+   * Multiply the denominator by [factor], which may not fit in 64 bits. In
+   * factored mode, a part of it over 64 bits without small prime factors is
+   * kept whole: as a prime if a Miller-Rabin test finds it (probably)
+   * prime, and as a composite cofactor otherwise.
+   */
+  void multiply(const BigNum &factor);
+
+  bool is_factored() const { return factored_; }
+
+  /**
+   * Compute the full value of the denominator (expanded mode only).
+   */
+  BigNum value(ThreadPool *pool) const;
+
+  /**
+   * Get the denominator as "p1^e1 p2^e2 ..." in increasing order of primes
+   * (factored mode only). Composite cofactors that could not be split
+   * follow as " * c1^f1 * c2^f2 ...".
+   */
+  std::string factors() const;
+
+  /**
+   * Get the base-2 logarithm of the denominator (factored mode only).
+   */
+  double log2() const;
+
+  /**
+   * Get the bytes allocated to record the factors, approximately.
+   */
+  size_t memory_usage() const;
+
+ private:
+  bool factored_;
+
+  // Factors recorded in expanded mode
+  std::vector<uint64_t> factors_;
+  std::vector<BigNum> big_factors_;
+
+  // Prime factorization in factored mode
+  std::map<uint64_t, uint64_t> exponents_;
+  // Primes over 64 bits, and parts of factors over 64 bits that could not be
+  // factored, in factored mode
+  std::map<BigNum, uint64_t> big_exponents_;
+  std::map<BigNum, uint64_t> cofactors_;
+  // Prime factorizations of factors seen so far
+  std::unordered_map<uint64_t, std::vector<std::pair<uint64_t, int>>>
+    factorizations_;
+};
+}  // namespace deweight
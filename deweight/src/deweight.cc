@@ -0,0 +1,110 @@
+/******************************************
+Copyright (c) 2020, Jeffrey Dudek
+******************************************/
+
+#include "src/deweight.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "src/reduction.h"
+
+void deweight_default_options(struct deweight_options *options) {
+  options->dyadic_bits = 0;
+  options->rounding = DEWEIGHT_ROUND_DOWN;
+  options->factored = 0;
+  options->num_threads = 1;
+}
+
+int deweight_reduce(int num_variables, const int *literals,
+                    size_t num_literals, const int *weighted,
+                    const int64_t *weight_nums, const int64_t *weight_denoms,
+                    size_t num_weights, const int *independent_support,
+                    size_t support_size,
+                    const struct deweight_options *options,
+                    struct deweight_result *result) {
+  deweight::ReductionOptions reduction_options;
+  reduction_options.dyadic_bits = options->dyadic_bits;
+  switch (options->rounding) {
+    case DEWEIGHT_ROUND_UP:
+      reduction_options.rounding = deweight::RoundingStrategy::up;
+      break;
+    case DEWEIGHT_ROUND_DOWN:
+      reduction_options.rounding = deweight::RoundingStrategy::down;
+      break;
+    case DEWEIGHT_ROUND_NEAR:
+      reduction_options.rounding = deweight::RoundingStrategy::near;
+      break;
+  }
+  reduction_options.factored = options->factored != 0;
+
+  deweight::ReductionResult reduced;
+  // Exceptions must not reach C callers
+  try {
+    std::vector<deweight::Rational> weights;
+    weights.reserve(num_weights);
+    for (size_t i = 0; i < num_weights; i++) {
+      weights.emplace_back(weight_nums[i], weight_denoms[i]);
+    }
+
+    int num_threads = options->num_threads;
+    if (num_threads <= 0) {
+      num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    deweight::ThreadPool pool(num_threads);
+    if (!deweight::reduce_weighted(
+          num_variables, literals, num_literals, weighted, weights.data(),
+          num_weights, independent_support,
+          independent_support == nullptr ? 0 : support_size,
+          reduction_options, &pool, &reduced)) {
+      return -1;
+    }
+  } catch (...) {
+    return -1;
+  }
+
+  // Copy into malloc'd memory, which the caller frees through the C ABI
+  result->num_variables = reduced.num_variables;
+  result->num_clauses = reduced.num_clauses;
+  result->num_literals = reduced.clauses.size();
+  result->clauses = static_cast<int *>(
+    malloc(std::max<size_t>(1, reduced.clauses.size()) * sizeof(int)));
+  result->denominator = static_cast<char *>(
+    malloc(reduced.denominator.size() + 1));
+  result->num_adjustments = reduced.adjustments.size();
+  result->adjustments = static_cast<struct deweight_adjustment *>(
+    malloc(std::max<size_t>(1, reduced.adjustments.size())
+           * sizeof(struct deweight_adjustment)));
+  if (result->clauses == nullptr || result->denominator == nullptr
+      || result->adjustments == nullptr) {
+    deweight_free_result(result);
+    return -1;
+  }
+  std::copy(reduced.clauses.begin(), reduced.clauses.end(), result->clauses);
+  memcpy(result->denominator, reduced.denominator.c_str(),
+         reduced.denominator.size() + 1);
+  for (size_t i = 0; i < reduced.adjustments.size(); i++) {
+    const deweight::Adjustment &adjustment = reduced.adjustments[i];
+    result->adjustments[i].var = adjustment.var;
+    result->adjustments[i].weight_num = adjustment.weight.num;
+    result->adjustments[i].weight_denom = adjustment.weight.denom;
+    result->adjustments[i].approx_num = adjustment.approx.num;
+    result->adjustments[i].approx_denom = adjustment.approx.denom;
+  }
+  return 0;
+}
+
+void deweight_free_result(struct deweight_result *result) {
+  free(result->clauses);
+  free(result->denominator);
+  free(result->adjustments);
+  result->clauses = nullptr;
+  result->denominator = nullptr;
+  result->adjustments = nullptr;
+  result->num_literals = 0;
+  result->num_adjustments = 0;
+}
@@ -0,0 +1,100 @@
+/******************************************
+Copyright (c) 2020, Jeffrey Dudek
+******************************************/
+
+/*
+ * C interface of libdeweight: reduce a weighted CNF held in memory to an
+ * unweighted one. See src/reduction.h for the C++ interface.
+ */
+
+#ifndef DEWEIGHT_H
+#define DEWEIGHT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Rounding of weights in the dyadic reduction */
+enum deweight_rounding {
+  DEWEIGHT_ROUND_UP,
+  DEWEIGHT_ROUND_DOWN,
+  DEWEIGHT_ROUND_NEAR
+};
+
+/* How deweight_reduce reduces a formula */
+struct deweight_options {
+  /* Bits per weight for the dyadic reduction (1-30), or 0 for general */
+  int dyadic_bits;
+  enum deweight_rounding rounding;
+  /* Give the denominator as "p1^e1 p2^e2 ..." instead of in decimal, with
+     any composites that could not be split after a " * " */
+  int factored;
+  /* Number of threads to use (0 for one per core) */
+  int num_threads;
+};
+
+/*
+ * A weight rounded by the dyadic reduction: the positive literal of [var]
+ * had weight [weight_num]/[weight_denom] and is reduced with weight
+ * [approx_num]/[approx_denom].
+ */
+struct deweight_adjustment {
+  int var;
+  int64_t weight_num;
+  int64_t weight_denom;
+  int64_t approx_num;
+  int64_t approx_denom;
+};
+
+/* An unweighted formula, allocated by deweight_reduce */
+struct deweight_result {
+  int num_variables;
+  size_t num_clauses;
+  /* Literals of the clauses, each clause ending with 0 */
+  int *clauses;
+  size_t num_literals;
+  /* The normalizing factor, as a NUL-terminated string */
+  char *denominator;
+  /* Weights rounded by the dyadic reduction, in the order they were reduced */
+  struct deweight_adjustment *adjustments;
+  size_t num_adjustments;
+};
+
+/*
+ * Fill [options] with the defaults: the general reduction, rounding down
+ * and a decimal denominator, on one thread.
+ */
+void deweight_default_options(struct deweight_options *options);
+
+/*
+ * Reduce the formula over [num_variables] variables with the clauses in
+ * [literals] (of which there are [num_literals]), each ending with 0.
+ * Literal [weighted][i] has weight [weight_nums][i]/[weight_denoms][i] for
+ * i < [num_weights]; other literals have weight 1. If [independent_support]
+ * is not NULL, only its [support_size] variables are reduced.
+ *
+ * Returns 0 and fills in [result], which must be released with
+ * deweight_free_result, or -1 if the formula or [options] are invalid
+ * (e.g. a negative weight) or the reduction fails (e.g. out of memory).
+ */
+int deweight_reduce(int num_variables, const int *literals,
+                    size_t num_literals, const int *weighted,
+                    const int64_t *weight_nums, const int64_t *weight_denoms,
+                    size_t num_weights, const int *independent_support,
+                    size_t support_size,
+                    const struct deweight_options *options,
+                    struct deweight_result *result);
+
+/*
+ * Release the memory held by [result].
+ */
+void deweight_free_result(struct deweight_result *result);
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif  /* DEWEIGHT_H */
@@ -5,6 +5,7 @@ Copyright (c) 2020, Jeffrey Dudek
 #include "src/formula.h"
 
 #include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <iterator>
 #include <limits>
@@ -13,6 +14,12 @@ Copyright (c) 2020, Jeffrey Dudek
 
 
 namespace deweight {
+  // Number of chunks to split a parallel parse into per thread, so that
+  // unevenly sized lines still balance
+  static const size_t kChunksPerThread = 4;
+  // Smallest chunk worth handing to another thread
+  static const size_t kMinChunkSize = 1 << 20;
+
   std::istream& operator>> (std::istream& is, WeightFormat& wf) {
     std::string val;
     is >> val;
@@ -31,204 +38,522 @@ namespace deweight {
     return is;
   }
 
-  void Formula::add_clause(std::vector<int> literals) {
+  void Formula::add_clause(const std::vector<int> &literals) {
     for (int literal : literals) {
-      body_.append(std::to_string(literal));
-      body_.push_back(' ');
+      add_literal(literal);
     }
-    body_.push_back('0');
-    body_.push_back('\n');
+    end_clause();
+  }
+
+  void Formula::end_clause() {
+    arena_.push_back(0);
     num_clauses_ += 1;
+    size_t begin = arena_used_;
+    arena_used_ = arena_.size();
+    add_segment(arena, begin, arena_used_);
+  }
+
+  int *Formula::reserve_clauses(size_t num_literals) {
+    size_t begin = arena_.size();
+    arena_.resize(begin + num_literals);
+    return arena_.data() + begin;
+  }
+
+  void Formula::add_clauses(size_t num_literals, size_t num_clauses) {
+    num_clauses_ += num_clauses;
+    size_t begin = arena_used_;
+    arena_used_ += num_literals;
+    add_segment(arena, begin, arena_used_);
+  }
+
+  std::vector<int> Formula::release_clauses() {
+    // Drop reserved clauses that were never added
+    arena_.resize(arena_used_);
+    arena_used_ = 0;
+    return std::move(arena_);
   }
 
-  void Formula::add_comment(std::string comment) {
+  void Formula::add_comment(const std::string &comment) {
+    size_t begin = body_.size();
     body_.push_back('c');
     body_.push_back(' ');
     body_.append(comment);
     body_.push_back('\n');
+    add_segment(body, begin, body_.size());
   }
 
-  Formula::Formula(StreamBuffer<FILE*, FN> *in, WeightFormat weights) {
-    std::string entry;
-    int line_num = 0;
+  void Formula::add_segment(Source source, size_t begin, size_t end) {
+    if (stream_ != nullptr) {
+      // Write the segment out now instead of keeping it
+      switch (source) {
+        case body:
+          stream_->write(body_.data() + begin, end - begin);
+          body_.clear();
+          break;
+        case input:
+          stream_->writeMapped(input_ + begin, end - begin);
+          break;
+        case arena:
+          write_arena(begin, end, stream_);
+          if (end == arena_.size()) {
+            // Keep reserved clauses that are not added yet
+            arena_.clear();
+            arena_used_ = 0;
+          }
+          break;
+      }
+      return;
+    }
+
+    if (!segments_.empty() && segments_.back().source == source
+        && segments_.back().end == begin) {
+      segments_.back().end = end;
+    } else {
+      segments_.push_back({source, begin, end});
+    }
+  }
+
+  void Formula::write_arena(size_t begin, size_t end,
+                            DimacsWriter *output) const {
+    for (size_t i = begin; i < end; i++) {
+      if (arena_[i] == 0) {
+        output->endClause();
+      } else {
+        output->writeLiteral(arena_[i]);
+      }
+    }
+  }
+
+  template <typename Input>
+  void Formula::append_line(Input *in) {
+    size_t begin = body_.size();
+    in->appendLine(body_);
+    body_.push_back('\n');
+    add_segment(body, begin, body_.size());
+  }
+
+  template <>
+  void Formula::append_line(MemoryBuffer *in) {
+    // Remember where the line is in the input instead of copying it
+    input_ = in->data();
+    in->skipWhitespace();
+    size_t begin = in->position();
+    in->skipToEOL();
+    if (**in == '\n') {
+      add_segment(input, begin, in->position() + 1);
+    } else {
+      // Last line of the input has no newline
+      add_segment(input, begin, in->position());
+      body_.push_back('\n');
+      add_segment(body, body_.size() - 1, body_.size());
+    }
+  }
+
+  template <typename Input>
+  Formula::Formula(Input *in, WeightFormat weights, DimacsWriter *stream,
+                   ThreadPool * /*pool*/)
+  : stream_(stream) {
+    parse(in, weights, 0);
+  }
+
+  template <>
+  Formula::Formula(MemoryBuffer *in, WeightFormat weights,
+                   DimacsWriter *stream, ThreadPool *pool)
+  : stream_(stream) {
+    size_t size = in->size() - in->position();
+    size_t num_chunks = pool == nullptr ? 1 : std::min<size_t>(
+      pool->size() * kChunksPerThread, size / kMinChunkSize);
+    if (num_chunks <= 1) {
+      parse(in, weights, 0);
+    } else {
+      parse_parallel(in, weights, num_chunks, pool);
+    }
+  }
+
+  template <typename Input>
+  void Formula::parse(Input *in, WeightFormat weights, int line_num) {
     for (;;) {
       in->skipWhitespace();
-      switch (**in) {
-        case EOF:
-          switch (weights) {
-            case WeightFormat::detect:
-            case WeightFormat::minic2d:
-            case WeightFormat::mc20:
-              break;
-            case WeightFormat::cachet_or_mc20:
-              // If only positive literals were assigned, assume cachet
-              add_comment("detected weight format: cachet");
-              weights = WeightFormat::cachet;
-              // (Fallthrough)
-            case WeightFormat::cachet:
-              for (int i = 1; i <= num_variables_; i++) {
-                auto weight = weights_.find(i);
-                if (weight != weights_.end()) {
-                  if (weights_.find(-i) == weights_.end()) {
-                    set_weight(-i, weight->second.complement());
-                  }
-                } else {
-                  set_weight(i, Rational(1, 2));
-                  set_weight(-i, Rational(1, 2));
-                }
-              }
-              break;
-          }
-          return;
-        case 'p':
-          if (!in->consume("p cnf ")) {
+      if (**in == EOF) {
+        finish_weights(weights);
+        return;
+      }
+      if (!parse_line(in, &weights, line_num)) {
+        return;
+      }
+      in->skipLine();
+      line_num++;
+    }
+  }
+
+  template <typename Input>
+  bool Formula::parse_line(Input *in, WeightFormat *weights, int line_num) {
+    std::string entry;
+    switch (**in) {
+      case 'p':
+        if (!in->consume("p cnf ")) {
+          set_header(0, 0);
+          return false;
+        }
+        int num_variables, num_clauses;
+        in->parseInt(num_variables, line_num);
+        in->parseInt(num_clauses, line_num);
+        set_header(num_variables, num_clauses);
+        break;
+      case 'w':
+        if (!in->consume("w ")) {
+          set_header(0, 0);
+          return false;
+        }
+
+        switch (*weights) {
+          case WeightFormat::minic2d:
             set_header(0, 0);
-            return;
-          }
-          int num_variables, num_clauses;
-          in->parseInt(num_variables, line_num);
-          in->parseInt(num_clauses, line_num);
-          set_header(num_variables, num_clauses);
-          break;
-        case 'w':
-          if (!in->consume("w ")) {
+            return false;
+          case WeightFormat::detect:
+            // cachet vs mc20 is ambiguous until a negative literal is seen
+            *weights = WeightFormat::cachet_or_mc20;
+            break;
+          case WeightFormat::mc20:
+          case WeightFormat::cachet_or_mc20:
+          case WeightFormat::cachet:
+            break;
+        }
+
+        int literal;
+        in->parseInt(literal, line_num);
+        if (!is_valid_literal(literal)) {
+          set_header(0, 0);
+          return false;
+        }
+
+        if (literal < 0) {
+          if (*weights == WeightFormat::cachet) {
             set_header(0, 0);
-            return;
+            return false;
+          } else if (*weights == WeightFormat::cachet_or_mc20) {
+            // Once a negative literal occurs, we must be in the mc20 format
+            add_comment("detected weight format: mc20");
+            *weights = WeightFormat::mc20;
           }
+        }
 
-          switch (weights) {
-            case WeightFormat::minic2d:
-              set_header(0, 0);
-              return;
-            case WeightFormat::detect:
-              // cachet vs mc20 is ambiguous until a negative literal is seen
-              weights = WeightFormat::cachet_or_mc20;
-              break;
-            case WeightFormat::mc20:
+        in->parseString(entry);
+        if (entry == "-1") {
+          switch (*weights) {
             case WeightFormat::cachet_or_mc20:
+              add_comment("detected weight format: cachet");
+              *weights = WeightFormat::cachet;
+              // (Fallthrough)
             case WeightFormat::cachet:
+              // A weight of -1 indicates the same weight for x and -x
+              set_weight(literal, Rational(1, 1));
+              set_weight(-literal, Rational(1, 1));
               break;
-          }
-
-          int literal;
-          in->parseInt(literal, line_num);
-          if (!is_valid_literal(literal)) {
-            set_header(0, 0);
-            return;
-          }
-
-          if (literal < 0) {
-            if (weights == WeightFormat::cachet) {
+            default:
+              // But weights must be positive in mc20
               set_header(0, 0);
-              return;
-            } else if (weights == WeightFormat::cachet_or_mc20) {
-              // Once a negative literal occurs, we must be in the mc20 format
-              add_comment("detected weight format: mc20");
-              weights = WeightFormat::mc20;
-            }
-          }
-
-          in->parseString(entry);
-          if (entry == "-1") {
-            switch (weights) {
-              case WeightFormat::cachet_or_mc20:
-                add_comment("detected weight format: cachet");
-                weights = WeightFormat::cachet;
-                // (Fallthrough)
-              case WeightFormat::cachet:
-                // A weight of -1 indicates the same weight for x and -x
-                set_weight(literal, Rational(1, 1));
-                set_weight(-literal, Rational(1, 1));
-                break;
-              default:
-                // But weights must be positive in mc20
-                set_header(0, 0);
-                return;
-            }
-          } else {
-            set_weight(literal, Rational::parse(entry));
+              return false;
           }
+        } else {
+          parse_weight(literal, entry);
+        }
+        break;
+      case 'c':
+        if (!in->consume("c")) {
+          set_header(0, 0);
+          return false;
+        }
+        if (!in->consume(" ")) {
+          // Handle lines of 'c\n'
+          body_.push_back('c');
+          body_.push_back('\n');
+          add_segment(body, body_.size() - 2, body_.size());
           break;
-        case 'c':
-          if (!in->consume("c")) {
-            set_header(0, 0);
-            return;
+        }
+        in->parseString(entry);
+        if (entry == "ind") {
+          int variable;
+          in->parseInt(variable, line_num);
+          while (variable != 0) {
+            add_independent_support(variable);
+            in->parseInt(variable, line_num);
           }
-          if (!in->consume(" ")) {
-            // Handle lines of 'c\n'
-            body_.push_back('c');
-            body_.push_back('\n');
-            break;
+        } else if (entry == "weights" && (*weights == WeightFormat::detect ||
+                                          *weights == WeightFormat::minic2d)) {
+          if (*weights == WeightFormat::detect) {
+            add_comment("detected weight format: minic2d");
+            *weights = WeightFormat::minic2d;
           }
-          in->parseString(entry);
-          if (entry == "ind") {
-            int variable;
-            in->parseInt(variable, line_num);
-            while (variable != 0) {
-              add_independent_support(variable);
-              in->parseInt(variable, line_num);
-            }
-          } else if (entry == "weights" && (weights == WeightFormat::detect ||
-                                            weights == WeightFormat::minic2d)) {
-            if (weights == WeightFormat::detect) {
-              add_comment("detected weight format: minic2d");
-              weights = WeightFormat::minic2d;
-            }
-            for (int i = 1; i <= num_variables_; i++) {
-              in->parseString(entry);
-              set_weight(i, Rational::parse(entry));
-              in->parseString(entry);
-              set_weight(-i, Rational::parse(entry));
-            }
-          } else {
-            // First word of comment was consumed; re-add it
-            body_.push_back('c');
-            body_.push_back(' ');
-            body_.append(entry);
-            body_.push_back(' ');
-            in->appendLine(body_);
-            body_.push_back('\n');
+          for (int i = 1; i <= num_variables_; i++) {
+            in->parseString(entry);
+            parse_weight(i, entry);
+            in->parseString(entry);
+            parse_weight(-i, entry);
           }
-          break;
-        default:
+        } else {
+          // First word of comment was consumed; re-add it
+          size_t begin = body_.size();
+          body_.push_back('c');
+          body_.push_back(' ');
+          body_.append(entry);
+          body_.push_back(' ');
           in->appendLine(body_);
           body_.push_back('\n');
-          break;
+          add_segment(body, begin, body_.size());
+        }
+        break;
+      default:
+        append_line(in);
+        break;
+    }
+    return true;
+  }
+
+  void Formula::parse_weight(int literal, const std::string &entry) {
+    // A weight too large for a Rational parses as 0/0 and fills in [big],
+    // whose denominator is then nonzero
+    BigRational big(BigNum(0), BigNum(0));
+    Rational weight = Rational::parse(entry, &big);
+    if (weight.num == 0 && weight.denom == 0 && !big.denom.is_zero()) {
+      set_weight(literal, big);
+    } else {
+      set_weight(literal, weight);
+    }
+  }
+
+  void Formula::finish_weights(WeightFormat weights) {
+    switch (weights) {
+      case WeightFormat::detect:
+      case WeightFormat::minic2d:
+      case WeightFormat::mc20:
+        break;
+      case WeightFormat::cachet_or_mc20:
+        // If only positive literals were assigned, assume cachet
+        add_comment("detected weight format: cachet");
+        weights = WeightFormat::cachet;
+        // (Fallthrough)
+      case WeightFormat::cachet:
+        for (int i = 1; i <= num_variables_; i++) {
+          if (has_weight(i)) {
+            if (!has_weight(-i) && has_big_weight(i)) {
+              set_weight(-i, get_big_weight(i).complement());
+            } else if (!has_weight(-i)) {
+              set_weight(-i, get_weight(i).complement());
+            }
+          } else {
+            set_weight(i, Rational(1, 2));
+            set_weight(-i, Rational(1, 2));
+          }
+        }
+        break;
+    }
+  }
+
+  Formula::Chunk Formula::scan_chunk(const char *data, size_t begin,
+                                     size_t end) {
+    Chunk chunk;
+    const char *limit = data + end;
+    const char *line = data + begin;
+    while (line < limit) {
+      // Mirror one iteration of parse(): skipWhitespace, then the line
+      const char *first = scan::skipBlanks(line, limit);
+      const char *eol = scan::findNewline(first, limit);
+      const char *next = eol < limit ? eol + 1 : limit;
+      if (first == limit) {
+        break;  // Only blanks before the end of the input
+      }
+
+      char c = *first;
+      if (c == 'p' || c == 'w' || c == 'c' || c == static_cast<char>(EOF)
+          || eol == limit) {
+        // Headers, weights and comments update the formula, and a missing
+        // final newline must be added; these are parsed during the merge
+        chunk.runs.push_back({true, static_cast<size_t>(line - data),
+                              static_cast<size_t>(next - data),
+                              chunk.num_lines});
+      } else if (!chunk.runs.empty() && !chunk.runs.back().special
+                 && chunk.runs.back().end == static_cast<size_t>(first - data)) {
+        chunk.runs.back().end = next - data;
+      } else {
+        // Clauses are passed through from the first non-blank character
+        chunk.runs.push_back({false, static_cast<size_t>(first - data),
+                              static_cast<size_t>(next - data),
+                              chunk.num_lines});
+      }
+      chunk.num_lines++;
+      line = next;
+    }
+    return chunk;
+  }
+
+  void Formula::parse_parallel(MemoryBuffer *in, WeightFormat weights,
+                               size_t num_chunks, ThreadPool *pool) {
+    // Split the input into chunks of whole lines
+    const char *data = in->data();
+    size_t size = in->size();
+    std::vector<size_t> bounds = {in->position()};
+    for (size_t i = 1; i < num_chunks; i++) {
+      size_t target = bounds[0] + (size - bounds[0]) / num_chunks * i;
+      target = std::max(target, bounds.back());
+      const char *eol = scan::findNewline(data + target, data + size);
+      if (eol == data + size) {
+        break;
+      }
+      if (static_cast<size_t>(eol + 1 - data) > bounds.back()) {
+        bounds.push_back(eol + 1 - data);
       }
-      in->skipLine();
-      line_num++;
     }
+    bounds.push_back(size);
 
-    set_header(0, 0);
+    std::vector<std::future<Chunk>> pending;
+    for (size_t i = 0; i + 1 < bounds.size(); i++) {
+      size_t begin = bounds[i], end = bounds[i + 1];
+      pending.push_back(pool->submit([data, begin, end]() {
+        return scan_chunk(data, begin, end);
+      }));
+    }
+    // Chunks must not outlive an early return, since [data] may not either
+    auto drain = [&pending]() {
+      for (auto &result : pending) {
+        if (result.valid()) {
+          result.wait();
+        }
+      }
+    };
+
+    // Merge the chunks in order, parsing the lines that change the formula
+    input_ = data;
+    int line_base = 0;
+    for (auto &result : pending) {
+      Chunk chunk = result.get();
+      for (const Run &run : chunk.runs) {
+        if (!run.special) {
+          add_segment(input, run.begin, run.end);
+          continue;
+        }
+        int line_num = line_base + run.line;
+        in->seek(run.begin);
+        in->skipWhitespace();
+        if (**in == EOF) {
+          drain();
+          finish_weights(weights);
+          return;
+        }
+        if (!parse_line(in, &weights, line_num)) {
+          drain();
+          return;
+        }
+        in->skipLine();
+        if (in->position() != run.end) {
+          // The line did not end where the scan expected (e.g. at a NUL);
+          // parse the remaining input in order instead
+          drain();
+          parse(in, weights, line_num + 1);
+          return;
+        }
+      }
+      line_base += chunk.num_lines;
+    }
+    in->seek(size);
+    finish_weights(weights);
   }
 
+  template Formula::Formula(StreamBuffer<InputStream*, IS> *in,
+                            WeightFormat weights, DimacsWriter *stream,
+                            ThreadPool *pool);
+
   void Formula::set_weight(int literal, Rational weight) {
-    weights_.emplace(literal, weight);
+    size_t index = weight_index(literal);
+    if (index >= weights_.size()) {
+      // Make room for every literal in the header at once
+      size_t size = std::max(index + 1, 2 * num_variables_ + 2);
+      weights_.resize(size, Rational(1, 1));
+      has_weight_.resize(size, false);
+    }
+    // The first weight given for a literal is kept
+    if (!has_weight_[index]) {
+      weights_[index] = weight;
+      has_weight_[index] = true;
+    }
+  }
+
+  void Formula::set_weight(int literal, const BigRational &weight) {
+    if (!has_weight(literal)) {
+      set_weight(literal, Rational(0, 0));
+      big_weights_.emplace(weight_index(literal), weight);
+    }
+  }
+
+  BigRational Formula::get_big_weight(int literal) const {
+    auto found = big_weights_.find(weight_index(literal));
+    if (found == big_weights_.end()) {
+      return BigRational(get_weight(literal));
+    }
+    return found->second;
+  }
+
+  std::vector<std::pair<std::string, size_t>> Formula::memory_usage() const {
+    size_t big_weights = big_weights_.bucket_count() * sizeof(void *);
+    for (const auto &weight : big_weights_) {
+      big_weights += sizeof(weight)
+                     + (weight.second.num.num_limbs()
+                        + weight.second.denom.num_limbs()) * sizeof(uint64_t);
+    }
+    return {
+      {"body", body_.capacity()},
+      {"arena", arena_.capacity() * sizeof(int)},
+      {"segments", segments_.capacity() * sizeof(Segment)},
+      {"weights", weights_.capacity() * sizeof(Rational)
+                  + has_weight_.capacity() / 8 + big_weights},
+      {"independent_support", independent_support_.capacity() * sizeof(int)}
+    };
   }
 
   Rational Formula::get_weight(int literal) const {
-    auto elem = weights_.find(literal);
-    if (elem == weights_.end()) {
+    size_t index = weight_index(literal);
+    if (index >= weights_.size()) {
       return Rational(1, 1);
-    } else {
-      return elem->second;
     }
+    return weights_[index];
   }
 
-  void Formula::write(std::ostream *output) const {
-    // Write header
-    *output << "p cnf " << num_variables_ << " " << num_clauses_ << "\n";
-
-    // Write independent support
+  void Formula::write_independent_support(DimacsWriter *output) const {
     if (independent_support_.size() > 0) {
-      *output << "c ind";
+      output->write("c ind", 5);
       for (int variable : independent_support_) {
-        *output << " " << variable;
+        output->writeChar(' ');
+        output->writeInt(variable);
       }
-      *output << " 0\n";
+      output->write(" 0\n", 3);
     }
+  }
 
-    // Write clauses
-    *output << body_;
+  void Formula::write(DimacsWriter *output) const {
+    // Write header
+    output->write("p cnf ", 6);
+    output->writeInt(num_variables_);
+    output->writeChar(' ');
+    output->writeInt(num_clauses_);
+    output->writeChar('\n');
+
+    write_independent_support(output);
+
+    // Write clauses, taking passthrough clauses straight from the input
+    for (const Segment &segment : segments_) {
+      switch (segment.source) {
+        case body:
+          output->write(body_.data() + segment.begin,
+                        segment.end - segment.begin);
+          break;
+        case input:
+          output->writeMapped(input_ + segment.begin,
+                              segment.end - segment.begin);
+          break;
+        case arena:
+          write_arena(segment.begin, segment.end, output);
+          break;
+      }
+    }
   }
 }  // namespace deweight
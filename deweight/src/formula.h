@@ -4,14 +4,19 @@ Copyright (c) 2020, Jeffrey Dudek
 
 #pragma once
 
+#include <cstdlib>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "../lib/compression.h"
+#include "../lib/dimacswriter.h"
+#include "../lib/memorybuffer.h"
 #include "../lib/streambuffer.h"
 #include "../lib/cxxopts.hpp"
 #include "src/rational.h"
+#include "src/thread_pool.h"
 
 namespace deweight {
 /**
@@ -29,8 +34,26 @@ class Formula {
   * Parses a file in DIMACS format into a boolean formula.
   *
   * Returns the parsed formula if the DIMACS file is in a valid format.
+  * [in] is either a StreamBuffer or a MemoryBuffer. Clauses parsed from a
+  * MemoryBuffer are not copied; its memory must outlive the formula and the
+  * output it is written to must be flushed before it is freed.
+  *
+  * If [stream] is provided, clauses and comments are written to it as soon
+  * as they are parsed or added instead of being kept in memory. The caller
+  * is then responsible for the header and independent support.
+  *
+  * If [pool] is provided, a large MemoryBuffer is split into chunks of lines
+  * that are scanned in parallel and then merged in order.
   */
-  explicit Formula(StreamBuffer<FILE*, FN> *in, WeightFormat weights);
+  template <typename Input>
+  explicit Formula(Input *in, WeightFormat weights,
+                   DimacsWriter *stream = nullptr, ThreadPool *pool = nullptr);
+
+  /**
+   * Creates a formula over [num_variables] variables with no clauses, to be
+   * filled in with add_clause, set_weight and add_independent_support.
+   */
+  explicit Formula(int num_variables) : num_variables_(num_variables) {}
 
   Formula(const Formula& other) = default;
   Formula& operator=(const Formula& other) = default;
@@ -43,12 +66,45 @@ class Formula {
   /**
    * Adds a CNF clause to the formula containing the provided literals.
    */
-  void add_clause(std::vector<int> literals);
+  void add_clause(const std::vector<int> &literals);
+
+  /**
+   * Appends [literal] to the clause being added. Together with end_clause,
+   * this lets clauses be added without building them first.
+   */
+  void add_literal(int literal) {
+    arena_.push_back(literal);
+  }
+
+  /**
+   * Ends the clause being added.
+   */
+  void end_clause();
+
+  /**
+   * Makes room for [num_literals] literals of generated clauses and returns
+   * where they start. They may be filled in (each clause ending with 0) from
+   * any thread, and must then be added in order with add_clauses before any
+   * other clause is added.
+   */
+  int *reserve_clauses(size_t num_literals);
+
+  /**
+   * Adds the next [num_clauses] reserved clauses, spanning [num_literals].
+   */
+  void add_clauses(size_t num_literals, size_t num_clauses);
+
+  /**
+   * Moves out the literals of the clauses added with add_clause(s), each
+   * clause ending with 0. Clauses passed through from the input are not
+   * included. The formula cannot be written afterwards.
+   */
+  std::vector<int> release_clauses();
 
   /**
    * Adds a comment at the bottom of the formula.
    */
-  void add_comment(std::string comment);
+  void add_comment(const std::string &comment);
 
   /**
    * Get the next free variable id.
@@ -60,7 +116,12 @@ class Formula {
   /**
    * Output the unweighted DIMACS of this formula.
    */
-  void write(std::ostream *output) const;
+  void write(DimacsWriter *output) const;
+
+  /**
+   * Output the independent support as a "c ind" line, if there is one.
+   */
+  void write_independent_support(DimacsWriter *output) const;
 
   /**
    * Get the weight of a literal.
@@ -71,6 +132,22 @@ class Formula {
    * Set the weight of a literal.
    */
   void set_weight(int literal, Rational weight);
+  void set_weight(int literal, const BigRational &weight);
+
+  /**
+   * Return true if the weight of [literal] does not fit in a Rational. Its
+   * weight is then only given by get_big_weight (get_weight gives 0/0).
+   */
+  bool has_big_weight(int literal) const {
+    // Invalid weights also have a zero denominator
+    return get_weight(literal).denom == 0
+           && big_weights_.count(weight_index(literal)) > 0;
+  }
+
+  /**
+   * Get the weight of a literal exactly, however large it is.
+   */
+  BigRational get_big_weight(int literal) const;
 
   /**
    * Return true if the provided literal can be used in the formula.
@@ -95,18 +172,144 @@ class Formula {
   }
 
   int num_variables() const { return num_variables_; }
+  size_t num_clauses() const { return num_clauses_; }
+
+  /**
+   * Get the bytes allocated by each part of the formula, by name.
+   */
+  std::vector<std::pair<std::string, size_t>> memory_usage() const;
 
  private:
+  /**
+   * Where the output of a segment is taken from.
+   */
+  enum Source {body, input, arena};
+
+  /**
+   * A range of output bytes in body_ or the input, or of literals in arena_.
+   */
+  struct Segment {
+    Source source;
+    size_t begin;
+    size_t end;
+  };
+
+  /**
+   * Appends the range [begin, end) of [source] to the output.
+   */
+  void add_segment(Source source, size_t begin, size_t end);
+
+  /**
+   * Writes the clauses in [begin, end) of arena_ in DIMACS.
+   */
+  void write_arena(size_t begin, size_t end, DimacsWriter *output) const;
+
+  /**
+   * A run of input lines found while scanning a chunk: either clauses to pass
+   * through, or a single line that must be parsed in order.
+   */
+  struct Run {
+    bool special;
+    size_t begin;
+    size_t end;
+    // Index of the first line of the run within its chunk
+    int line;
+  };
+
+  /**
+   * The runs of lines in one chunk of the input.
+   */
+  struct Chunk {
+    std::vector<Run> runs;
+    int num_lines = 0;
+  };
+
+  /**
+   * Parses lines from [in] until the end of the input or an error.
+   */
+  template <typename Input>
+  void parse(Input *in, WeightFormat weights, int line_num);
+
+  /**
+   * Parses the line starting at the current (non-blank) character of [in].
+   *
+   * Returns false if the formula is invalid.
+   */
+  template <typename Input>
+  bool parse_line(Input *in, WeightFormat *weights, int line_num);
+
+  /**
+   * Sets the weight of [literal] to the weight written as [entry], exactly
+   * however large it is.
+   */
+  void parse_weight(int literal, const std::string &entry);
+
+  /**
+   * Fills in missing weights once the whole input has been parsed.
+   */
+  void finish_weights(WeightFormat weights);
+
+  /**
+   * Splits the lines of [data] in [begin, end) into runs.
+   */
+  static Chunk scan_chunk(const char *data, size_t begin, size_t end);
+
+  /**
+   * Parses [in] by scanning [num_chunks] chunks in parallel on [pool].
+   */
+  void parse_parallel(MemoryBuffer *in, WeightFormat weights,
+                      size_t num_chunks, ThreadPool *pool);
+
+  /**
+   * Passes the rest of the current input line through to the output.
+   */
+  template <typename Input>
+  void append_line(Input *in);
+
+  /**
+   * Position of the weight of [literal] in weights_: 2*var, plus 1 if negated.
+   */
+  static size_t weight_index(int literal) {
+    return 2 * static_cast<size_t>(std::abs(literal)) + (literal < 0 ? 1 : 0);
+  }
+
+  /**
+   * Return true if a weight was set for [literal].
+   */
+  bool has_weight(int literal) const {
+    size_t index = weight_index(literal);
+    return index < has_weight_.size() && has_weight_[index];
+  }
+
   // Number of variables in the formula
   size_t num_variables_ = 0;
   size_t num_clauses_ = 0;
 
-  // List of clauses and comments
+  // Generated comments
   std::string body_ = "";
+  // Literals of generated clauses, each clause ending with 0
+  std::vector<int> arena_;
+  // Length of the prefix of arena_ that is covered by segments
+  size_t arena_used_ = 0;
+  // Input that passthrough clauses are taken from, if it is in memory
+  const char *input_ = nullptr;
+  // Output after the header, in order
+  std::vector<Segment> segments_;
+  // Output to write segments to immediately, if streaming
+  DimacsWriter *stream_ = nullptr;
 
   // Independent support
   std::vector<int> independent_support_;
-  // Set of weights
-  std::unordered_map<int, Rational> weights_;
+  // Weights indexed by weight_index, sized from the header when first set;
+  // literals without a weight have weight 1
+  std::vector<Rational> weights_;
+  std::vector<bool> has_weight_;
+  // Weights that do not fit in a Rational, by weight_index; their entry in
+  // weights_ is 0/0
+  std::unordered_map<size_t, BigRational> big_weights_;
 };
+
+template <>
+Formula::Formula(MemoryBuffer *in, WeightFormat weights, DimacsWriter *stream,
+                 ThreadPool *pool);
 }  // namespace deweight
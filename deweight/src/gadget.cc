@@ -0,0 +1,124 @@
+/******************************************
+Copyright (c) 2020, Jeffrey Dudek
+******************************************/
+
+#include "src/gadget.h"
+
+#include <algorithm>
+
+namespace deweight {
+  /**
+   * Get the fewest variables n with 2^n >= [value].
+   */
+  template <typename Count>
+  static size_t vars_to_count(const Count &value) {
+    // 2^(length - 1) <= value < 2^length, so only a power of 2 needs fewer
+    size_t length = bit_length(value);
+    for (size_t bit = 0; bit + 1 < length; bit++) {
+      if (test_bit(value, bit)) {
+        return length;
+      }
+    }
+    return length == 0 ? 0 : length - 1;
+  }
+
+  template <typename Count>
+  Gadget Gadget::reduction(const Count &pos_sol, const Count &neg_sol) {
+    Gadget gadget;
+
+    // Add the number of variables needed to represent both weights.
+    // (n variables can represent <= 2^n)
+    std::vector<int> vars;
+    size_t num_vars = std::max(vars_to_count(pos_sol), vars_to_count(neg_sol));
+    for (size_t i = 0; i < num_vars; i++) {
+      vars.push_back(kFirstAuxHole + static_cast<int>(i));
+    }
+    gadget.num_aux_ = vars.size();
+
+    // var  -> [pos_sol] solutions
+    if (bit_length(pos_sol) == 0) {
+      gadget.add_literal(-kVarHole);
+      gadget.end_clause();
+    } else {
+      chain_formula(vars.data(), vars.size(), pos_sol, -kVarHole, &gadget);
+    }
+    // -var -> [neg weight] solutions
+    if (bit_length(neg_sol) == 0) {
+      gadget.add_literal(kVarHole);
+      gadget.end_clause();
+    } else {
+      chain_formula(vars.data(), vars.size(), neg_sol, kVarHole, &gadget);
+    }
+    return gadget;
+  }
+
+  template Gadget Gadget::reduction(const uint128 &pos_sol,
+                                    const uint128 &neg_sol);
+  template Gadget Gadget::reduction(const BigNum &pos_sol,
+                                    const BigNum &neg_sol);
+
+  Gadget Gadget::dyadic(int num, int bits) {
+    Gadget gadget;
+    std::vector<int> vars;
+    for (int i = 0; i < bits; i++) {
+      vars.push_back(kFirstAuxHole + i);
+    }
+    gadget.num_aux_ = vars.size();
+
+    // var -> [pos weight] solutions
+    chain_formula(vars.data(), vars.size(), num, -kVarHole, &gadget);
+
+    // -var -> [neg weight] solutions
+    for (int i = 0; i < bits; i++) {
+      vars[i] = -vars[i];  // start counting from the lexicographic bottom
+    }
+    chain_formula(vars.data(), vars.size(), (1 << bits) - num, kVarHole,
+                  &gadget);
+    return gadget;
+  }
+
+  void Gadget::instantiate(int var, int first_aux, int *out) const {
+    for (int literal : literals_) {
+      if (literal == 0) {
+        *out++ = 0;
+        continue;
+      }
+      int hole = std::abs(literal);
+      int id = hole == kVarHole ? var : first_aux + (hole - kFirstAuxHole);
+      *out++ = literal < 0 ? -id : id;
+    }
+  }
+
+  const Gadget &GadgetCache::reduction(uint128 pos_sol, uint128 neg_sol) {
+    auto key = std::make_pair(pos_sol, neg_sol);
+    auto found = reduction_.find(key);
+    if (found != reduction_.end()) {
+      hits_++;
+      return found->second;
+    }
+    return reduction_.emplace(key, Gadget::reduction(pos_sol, neg_sol))
+      .first->second;
+  }
+
+  const Gadget &GadgetCache::reduction(const BigNum &pos_sol,
+                                       const BigNum &neg_sol) {
+    auto key = std::make_pair(pos_sol, neg_sol);
+    auto found = big_reduction_.find(key);
+    if (found != big_reduction_.end()) {
+      hits_++;
+      return found->second;
+    }
+    return big_reduction_.emplace(key, Gadget::reduction(pos_sol, neg_sol))
+      .first->second;
+  }
+
+  const Gadget &GadgetCache::dyadic(int num, int bits) {
+    auto key = std::make_pair(num, bits);
+    auto found = dyadic_.find(key);
+    if (found != dyadic_.end()) {
+      hits_++;
+      return found->second;
+    }
+    return dyadic_.emplace(key, Gadget::dyadic(num, bits)).first->second;
+  }
+}  // namespace deweight
@@ -0,0 +1,204 @@
+/******************************************
+Copyright (c) 2020, Jeffrey Dudek
+******************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "src/rational.h"
+
+namespace deweight {
+/**
+ * Return true if bit [bit] of [value] >= 0 is 1. [bit] must be less than
+ * the width of [Int].
+ */
+template <typename Int>
+inline bool test_bit(Int value, size_t bit) {
+  return ((value >> bit) & 1) != 0;
+}
+
+inline bool test_bit(const BigNum &value, size_t bit) {
+  return value.test_bit(bit);
+}
+
+/**
+ * Get the number of bits up to the highest 1 bit of [value] >= 0.
+ */
+template <typename Int>
+inline size_t bit_length(Int value) {
+  uint128 wide = static_cast<uint128>(value);
+  uint64_t high = static_cast<uint64_t>(wide >> 64);
+  if (high != 0) {
+    return 128 - __builtin_clzll(high);
+  }
+  uint64_t low = static_cast<uint64_t>(wide);
+  return low == 0 ? 0 : 64 - __builtin_clzll(low);
+}
+
+inline size_t bit_length(const BigNum &value) {
+  return value.bit_length();
+}
+
+/**
+ * Writes the clauses for a formula over [vars] (of which there are
+ * [num_vars]) with the specified number of solutions to [sink], each
+ * starting with [prefix].
+ *
+ * [sink] must provide add_literal(int) and end_clause(). [Count] is an
+ * integer type wide enough for 2^[num_vars], or a BigNum.
+ */
+template <typename Count, typename Sink>
+void chain_formula(const int *vars, size_t num_vars,
+                   const Count &num_solutions, int prefix, Sink *sink) {
+  size_t length = bit_length(num_solutions);
+  // For weight 0, write an UNSAT formula
+  if (length == 0) {
+    sink->add_literal(prefix);
+    if (num_vars == 0) {
+      sink->end_clause();
+      return;
+    }
+    sink->add_literal(vars[0]);
+    sink->end_clause();
+    sink->add_literal(prefix);
+    sink->add_literal(-vars[0]);
+    sink->end_clause();
+    return;
+  }
+
+  size_t lowest = 0;
+  while (!test_bit(num_solutions, lowest)) {
+    lowest++;
+  }
+  // For maximum weight (2^num_vars), write the completely SAT formula
+  if (lowest == num_vars && length == num_vars + 1) {
+    return;
+  }
+
+  if (length > num_vars) {
+    std::cerr << "Unable to form " << to_string(num_solutions) << "solutions";
+    std::cerr << " with " << num_vars << " variables" << std::endl;
+    return;
+  }
+
+  // A clause starts at the lowest 1 bit and at every 0 bit above it, and
+  // each 1 bit adds its variable (as a disjunction) to every earlier clause.
+  for (size_t start = lowest; start < num_vars; start++) {
+    if (start != lowest && test_bit(num_solutions, start)) {
+      continue;
+    }
+    sink->add_literal(prefix);
+    sink->add_literal(vars[start]);
+    for (size_t bit = start + 1; bit < num_vars; bit++) {
+      if (test_bit(num_solutions, bit)) {
+        sink->add_literal(vars[bit]);
+      }
+    }
+    sink->end_clause();
+  }
+}
+
+/**
+ * The clauses that give one variable its weight, with the weighted variable
+ * and its auxiliary variables left as holes.
+ *
+ * A gadget is built once per distinct weight and then instantiated for each
+ * variable with that weight.
+ */
+class Gadget {
+ public:
+  /**
+   * Gadget for the reduction: var -> [pos_sol] and -var -> [neg_sol]
+   * solutions over the fewest auxiliary variables that can count both.
+   * [Count] is uint128 or, for weights too large for it, BigNum.
+   */
+  template <typename Count>
+  static Gadget reduction(const Count &pos_sol, const Count &neg_sol);
+
+  /**
+   * Gadget for the dyadic reduction of the weight [num]/2^[bits].
+   */
+  static Gadget dyadic(int num, int bits);
+
+  size_t num_aux() const { return num_aux_; }
+  size_t num_clauses() const { return num_clauses_; }
+  size_t num_literals() const { return literals_.size(); }
+
+  /**
+   * Write the clauses to [sink], for weighted variable [var] and auxiliary
+   * variables [first_aux], [first_aux]+1, ...
+   */
+  template <typename Sink>
+  void instantiate(int var, int first_aux, Sink *sink) const {
+    for (int literal : literals_) {
+      if (literal == 0) {
+        sink->end_clause();
+        continue;
+      }
+      int hole = std::abs(literal);
+      int id = hole == kVarHole ? var : first_aux + (hole - kFirstAuxHole);
+      sink->add_literal(literal < 0 ? -id : id);
+    }
+  }
+
+  /**
+   * Write the clause literals, each clause ending with 0, to [out], which
+   * must have room for num_literals().
+   */
+  void instantiate(int var, int first_aux, int *out) const;
+
+  // Gadgets are built by chain_formula through these
+  void add_literal(int hole) { literals_.push_back(hole); }
+  void end_clause() {
+    literals_.push_back(0);
+    num_clauses_++;
+  }
+
+ private:
+  // Hole of the weighted variable; auxiliary variable k is hole k + 2
+  static const int kVarHole = 1;
+  static const int kFirstAuxHole = 2;
+
+  Gadget() = default;
+
+  size_t num_aux_ = 0;
+  size_t num_clauses_ = 0;
+  // Clause literals over the holes, each clause ending with 0; negative
+  // for negation
+  std::vector<int> literals_;
+};
+
+/**
+ * Gadgets built so far, keyed by the weight they encode.
+ */
+class GadgetCache {
+ public:
+  const Gadget &reduction(uint128 pos_sol, uint128 neg_sol);
+  const Gadget &reduction(const BigNum &pos_sol, const BigNum &neg_sol);
+  const Gadget &dyadic(int num, int bits);
+
+  /**
+   * Number of distinct gadgets built.
+   */
+  size_t size() const {
+    return reduction_.size() + big_reduction_.size() + dyadic_.size();
+  }
+
+  /**
+   * Number of lookups that reused a gadget.
+   */
+  size_t hits() const { return hits_; }
+
+ private:
+  std::map<std::pair<uint128, uint128>, Gadget> reduction_;
+  std::map<std::pair<BigNum, BigNum>, Gadget> big_reduction_;
+  std::map<std::pair<int, int>, Gadget> dyadic_;
+  size_t hits_ = 0;
+};
+}  // namespace deweight
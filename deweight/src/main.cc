@@ -2,235 +2,385 @@
 Copyright (c) 2020, Jeffrey Dudek
 ******************************************/
 
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <iostream>
+#include <atomic>
 #include <chrono>
+#include <fstream>
+#include <future>
 #include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 #include "../lib/cxxopts.hpp"
-#include "../lib/BigInt.hpp"
+#include "src/bignum.h"
+#include "src/denominator.h"
 #include "src/formula.h"
+#include "src/gadget.h"
+#include "src/reduction.h"
+#include "src/stats.h"
+#include "src/thread_pool.h"
 
 
+// Width of the counts in the placeholder header written in streaming mode.
+// The counts are patched in, followed by a comment line that takes up the
+// rest, so the header line itself has no padding.
+static const int kHeaderWidth = 41;
+
 /**
- * Returns the clauses for a formula with the provided variables
- * with the specified number of solutions.
+ * Get the comments giving the normalizing factor of the reduction. The size
+ * of its value is recorded in [stats] (if provided).
  */
-std::vector<std::vector<int>> chain_formula(const std::vector<size_t> &vars,
-                                            int num_solutions) {
-  // For weight 0, return an UNSAT formula
-  if (num_solutions == 0) {
-    return {{static_cast<int>(vars[0])}, {-static_cast<int>(vars[0])}};
+std::string format_denominator(const deweight::Denominator &denom,
+                               deweight::ThreadPool *pool,
+                               deweight::Stats *stats) {
+  if (denom.is_factored()) {
+    std::string factors = denom.factors();
+    char log2[64];
+    snprintf(log2, sizeof(log2), "%.17g", denom.log2());
+    return std::string("c denom-factored") + (factors.empty() ? "" : " ")
+           + factors + "\nc log2denom " + log2 + "\n";
   }
-
-  // For maximum weight, return the completely SAT formula
-  if (num_solutions == (1 << vars.size())) {
-    return {};
+  deweight::BigNum value = denom.value(pool);
+  std::string digits = value.to_string(pool);
+  if (stats != nullptr) {
+    stats->set_memory("denominator_value", value.num_limbs() * 8);
+    stats->set_memory("denominator_digits", digits.size());
   }
+  return "c denom " + digits + "\n";
+}
 
-  if (num_solutions >= (1 << vars.size())) {
-    std::cerr << "Unable to form " << num_solutions << "solutions";
-    std::cerr << " with " << vars.size() << " variables" << std::endl;
-    return {};
+/**
+ * Record the memory held by [formula] and [denom] in [stats] (if provided),
+ * and report it with the peak RSS after [phase] to stderr if [verbose].
+ */
+void track_memory(deweight::Stats::Phase phase,
+                  const deweight::Formula &formula,
+                  const deweight::Denominator &denom,
+                  deweight::Stats *stats, bool verbose) {
+  size_t formula_bytes = 0;
+  for (const auto &part : formula.memory_usage()) {
+    formula_bytes += part.second;
+    if (stats != nullptr) {
+      stats->set_memory(part.first, part.second);
+    }
   }
-
-  std::vector<std::vector<int>> clauses;
-  int bit = 0;
-
-  // If the lowest bits are 0, ignore that variable.
-  while ((num_solutions & (1 << bit)) == 0) {
-    bit++;
+  if (stats != nullptr) {
+    stats->set_memory("denominator", denom.memory_usage());
   }
-
-  // Add a clause for the first 1 bit
-  clauses.push_back({static_cast<int>(vars[bit])});
-  bit++;
-
-  for (; bit < vars.size(); bit++) {
-    if ((num_solutions & (1 << bit)) > 0) {
-      // 1 bit implies disjunction in the chain formula
-      for (int i = 0; i < clauses.size(); i++) {
-        clauses[i].push_back(static_cast<int>(vars[bit]));
-      }
-    } else {
-      clauses.push_back({static_cast<int>(vars[bit])});
-    }
+  if (verbose) {
+    std::cerr << "c mem " << deweight::Stats::name(phase) << " peak_rss "
+              << deweight::Stats::peak_rss() << " formula " << formula_bytes
+              << " denominator " << denom.memory_usage() << std::endl;
   }
-  return clauses;
 }
 
 /**
- * Add clauses to [formula] so that all weights are captured in the clauses.
+ * Output the time taken since [start_time] as a comment.
  */
-BigInt reduce(deweight::Formula *formula) {
-  std::vector<int> free_variables = formula->get_independent_support();
-  // If there is no independent support, consider all variables
-  if (free_variables.size() == 0) {
-    for (int var = 1; var <= formula->num_variables(); var++) {
-      free_variables.push_back(var);
-    }
-  }
-
-  BigInt net_denom = 1;
-  for (int var : free_variables) {
-    deweight::Rational pos = formula->get_weight(var);
-    deweight::Rational neg = formula->get_weight(-var);
-
-    // Ensure both weights have identical denominators
-    int pos_sol, neg_sol, denom;
-    if (pos.denom == neg.denom) {
-      pos_sol = pos.num;
-      neg_sol = neg.num;
-      denom = pos.denom;
-    } else {
-      pos_sol = pos.num * neg.denom;
-      neg_sol = neg.num * pos.denom;
-      denom = pos.denom * neg.denom;
-    }
+void write_time(std::chrono::steady_clock::time_point start_time,
+                DimacsWriter *output) {
+  auto elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(
+    std::chrono::steady_clock::now() - start_time).count();
+  output->write("c deweight time ", 16);
+  output->writeDouble(elapsed, "%g");
+  output->writeChar('\n');
+}
 
-    // Simplify weights if possible
-    int gcd = std::__gcd(pos_sol, neg_sol);
-    gcd = std::__gcd(gcd, denom);
-    pos_sol /= gcd;
-    neg_sol /= gcd;
-    denom /= gcd;
+/**
+ * Record the size of the reduction of a formula with [num_variables] and
+ * [num_clauses] to [formula], and the bytes read and written, in [stats].
+ */
+void record_counts(const deweight::Formula &formula, int num_variables,
+                   size_t num_clauses, const deweight::GadgetCache &gadgets,
+                   size_t bytes_in, size_t bytes_out, deweight::Stats *stats) {
+  stats->set("variables", num_variables);
+  stats->set("clauses", num_clauses);
+  stats->set("aux_variables", formula.num_variables() - num_variables);
+  stats->set("gadget_clauses", formula.num_clauses() - num_clauses);
+  stats->set("weight_classes", gadgets.size());
+  stats->set("gadgets_reused", gadgets.hits());
+  stats->set("bytes_in", bytes_in);
+  stats->set("bytes_out", bytes_out);
+}
 
-    if (pos_sol < 0 || neg_sol < 0) {
-      std::cerr << "Skipping var " << var << " (negative weight)" << std::endl;
-      continue;
-    }
+/**
+ * Return true if [fd] is a regular file that can be written at an offset.
+ */
+bool is_patchable(int fd) {
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    return false;
+  }
+  // pwrite ignores the offset on files opened for appending
+  int flags = fcntl(fd, F_GETFL);
+  return flags >= 0 && (flags & O_APPEND) == 0
+    && lseek(fd, 0, SEEK_CUR) >= 0;
+}
 
-    // Add clauses to [formula] so that:
-    //   var  -> pos_sol solutions
-    //   -var -> neg_sol solutions
-
-    // Add the number of variables needed to represent both weights.
-    // (n variables can represent <= 2^n)
-    std::vector<size_t> vars;
-    int log = 0;
-    while ((1 << log) < pos_sol || (1 << log) < neg_sol) {
-      vars.push_back(formula->add_variable());
-      if (formula->has_independent_support()) {
-        formula->add_independent_support(vars.back());
+/**
+ * Get the files to reduce in --batch mode: the regular files in [path] (in
+ * order of name) if it is a directory, or else the paths listed in it, one
+ * per line. Returns false if [path] cannot be read.
+ */
+bool list_inputs(const std::string &path, std::vector<std::string> *inputs) {
+  DIR *dir = opendir(path.c_str());
+  if (dir != nullptr) {
+    while (struct dirent *entry = readdir(dir)) {
+      std::string file = path + "/" + entry->d_name;
+      struct stat st;
+      if (entry->d_name[0] != '.' && stat(file.c_str(), &st) == 0
+          && S_ISREG(st.st_mode)) {
+        inputs->push_back(file);
       }
-      log++;
     }
+    closedir(dir);
+    std::sort(inputs->begin(), inputs->end());
+    return true;
+  }
 
-    // var  -> [pos_sol] solutions
-    if (pos_sol == 0) {
-      formula->add_clause({-var});
-    } else {
-      for (auto &clause : chain_formula(vars, pos_sol)) {
-        clause.insert(clause.begin(), -var);
-        formula->add_clause(clause);
-      }
+  std::ifstream list(path);
+  if (!list) {
+    return false;
+  }
+  std::string line;
+  while (std::getline(list, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
     }
-    // -var -> [neg weight] solutions
-    if (neg_sol == 0) {
-      formula->add_clause({var});
-    } else {
-      for (auto &clause : chain_formula(vars, neg_sol)) {
-        clause.insert(clause.begin(), var);
-        formula->add_clause(clause);
-      }
+    if (!line.empty()) {
+      inputs->push_back(line);
     }
-
-    net_denom *= denom;
   }
-  return net_denom;
+  return true;
 }
 
 /**
- * Using the dyadic reduction, add clauses to [formula] so that all weights are 
- * captured in the clauses.
- * 
- * The denominators of weights must be powers of 2. All weights are rounded
- * to the nearest factor of 1/2^[bits_per_var] (rounding positive weight down).
+ * Get the path in [out_dir] to write the reduction of [input] to: its name,
+ * without the extension of a compression format.
  */
-BigInt reduce_dyadic(
-  deweight::Formula *formula,
-  int bits_per_var,
-  deweight::RoundingStrategy rounding) {
-  BigInt result = 1;
-  std::vector<int> free_variables = formula->get_independent_support();
-  // If there is no independent support, consider all variables
-  if (free_variables.size() == 0) {
-    for (int var = 1; var <= formula->num_variables(); var++) {
-      free_variables.push_back(var);
+std::string output_path(const std::string &input, const std::string &out_dir) {
+  std::string name = input.substr(input.find_last_of('/') + 1);
+  for (const char *extension : {".gz", ".xz", ".zst"}) {
+    size_t length = strlen(extension);
+    if (name.size() > length
+        && name.compare(name.size() - length, length, extension) == 0) {
+      name.resize(name.size() - length);
+      break;
     }
   }
+  return out_dir + "/" + name;
+}
 
-  for (int var : free_variables) {
-    deweight::Rational pos = formula->get_weight(var).simplify();
-    deweight::Rational neg = formula->get_weight(-var).simplify();
-
-    if (pos.denom != neg.denom || pos.num + neg.num != pos.denom) {
-      std::cerr << "Skipping var " << var << " (non-probabilistic weights)";
-      std::cerr << std::endl;
-      continue;
-    }
+/**
+ * The buffers for reading inputs that cannot be mapped, reused from file to
+ * file by a batch job. They are allocated by the first such input.
+ */
+struct InputBuffers {
+  std::unique_ptr<InputStream> decoder;
+  std::unique_ptr<StreamBuffer<InputStream*, IS>> in;
+};
 
-    if (pos.num < 0 || neg.num < 0) {
-      std::cerr << "Skipping var " << var << " (negative weight)" << std::endl;
-      continue;
+/**
+ * Reduce the weighted CNF at [input_path] and write the result to
+ * [output_path] through [output] and [buffers], which are reused from file
+ * to file.
+ *
+ * The run is recorded in [stats], including its "status": "ok", or why the
+ * file could not be reduced, in which case false is returned.
+ */
+bool reduce_file(const std::string &input_path,
+                 const std::string &output_path,
+                 deweight::WeightFormat weight_format,
+                 const deweight::ReductionOptions &options,
+                 DimacsWriter *output, InputBuffers *buffers,
+                 deweight::ThreadPool *pool, deweight::Stats *stats) {
+  auto start_time = std::chrono::steady_clock::now();
+  stats->set_string("input", input_path);
+  stats->set_string("output", output_path);
+
+  // Map the input file if possible; otherwise stream and decompress it
+  MappedFile input;
+  std::unique_ptr<deweight::Formula> formula;
+  size_t bytes_in = 0;
+  // Whether a compressed input turned out to be corrupt or truncated
+  bool read_failed = false;
+  {
+    deweight::Stats::Timer timer(stats, deweight::Stats::parse);
+    if (input.open(input_path)
+        && detectCompression(input.data(), input.size())
+           == Compression::none) {
+      MemoryBuffer in(input.data(), input.size());
+      formula.reset(new deweight::Formula(&in, weight_format));
+      bytes_in = input.size();
+    } else {
+      input.close();
+      std::unique_ptr<FILE, decltype(&fclose)> stream(
+        fopen(input_path.c_str(), "rb"), &fclose);
+      if (stream == nullptr) {
+        stats->set_string("status", "unable to open input");
+        return false;
+      }
+      if (buffers->decoder == nullptr) {
+        buffers->decoder.reset(new InputStream(stream.get()));
+        buffers->in.reset(
+          new StreamBuffer<InputStream*, IS>(buffers->decoder.get()));
+      } else {
+        buffers->decoder->reset(stream.get());
+        buffers->in->reset(buffers->decoder.get());
+      }
+      formula.reset(new deweight::Formula(buffers->in.get(), weight_format));
+      bytes_in = buffers->decoder->bytesRead();
+      read_failed = buffers->decoder->failed();
     }
+  }
+  if (read_failed || formula->num_variables() == 0) {
+    stats->set_string("status", "unable to read formula");
+    return false;
+  }
+  int num_variables = formula->num_variables();
+  size_t num_clauses = formula->num_clauses();
+
+  deweight::Denominator denom(options.factored);
+  track_memory(deweight::Stats::parse, *formula, denom, stats, false);
+  deweight::GadgetCache gadgets;
+  if (options.dyadic_bits > 0) {
+    deweight::reduce_dyadic(formula.get(), options.dyadic_bits,
+                            options.rounding, &gadgets, &denom, pool, stats);
+  } else {
+    deweight::reduce(formula.get(), &gadgets, &denom, pool, stats);
+  }
+  track_memory(deweight::Stats::reduction, *formula, denom, stats, false);
 
-    if (pos.num == 1 && neg.num == 1 && pos.denom == 1) {
-      result *= 2;
-      continue;  // No need to modify unweighted variables.
-    }
+  std::string denom_comments;
+  {
+    deweight::Stats::Timer timer(stats, deweight::Stats::denominator);
+    denom_comments = format_denominator(denom, pool, stats);
+  }
 
-    // Round the weight to the nearest dyadic weight
-    // (rounding the positive weight down)
-    auto approx = pos.round(1 << bits_per_var, rounding).simplify();
-    int bits_needed = 0;
-    while ((1 << bits_needed) < approx.denom) {
-      bits_needed++;
+  {
+    deweight::Stats::Timer timer(stats, deweight::Stats::write);
+    int fd = open(output_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      stats->set_string("status", "unable to open output");
+      return false;
     }
-    formula->add_comment(
-      "adjust w " + std::to_string(var)
-       + " " + deweight::to_string(pos)
-       + " to " + deweight::to_string(approx));
-
-    if (approx.num == 1 && approx.denom == 2) {
-      // No need to include any variables for weights (1/2, 1/2)
-      result *= 2;
-      continue;
+    output->reset(fd);
+    output->write(denom_comments);
+    write_time(start_time, output);
+    formula->write(output);
+    bool written = output->flush();
+    if (close(fd) != 0 || !written) {
+      stats->set_string("status", "unable to write output");
+      return false;
     }
+  }
+  track_memory(deweight::Stats::write, *formula, denom, stats, false);
 
-    // Add clauses for chain formula
-    std::vector<size_t> vars;
-    for (int i = 0; i < bits_needed; i++) {
-      vars.push_back(formula->add_variable());
-      if (formula->has_independent_support()) {
-        formula->add_independent_support(vars.back());
-      }
-    }
+  record_counts(*formula, num_variables, num_clauses, gadgets, bytes_in,
+                output->bytesWritten(), stats);
+  stats->set_string("status", "ok");
+  return true;
+}
 
-    // var -> [pos weight] solutions
-    for (auto &clause : chain_formula(vars, approx.num)) {
-      clause.insert(clause.begin(), -var);
-      formula->add_clause(clause);
+/**
+ * Reduce every file given by [list] (see list_inputs) into [out_dir],
+ * [num_jobs] files at a time, and write a line of statistics for each file
+ * to [stats_path] (or stdout if it is empty).
+ *
+ * Each job takes the next file that no job has started, so long and short
+ * files balance, and keeps its input and output buffers from one file to
+ * the next.
+ * Returns 0 if every file was reduced.
+ */
+int run_batch(const std::string &list, const std::string &out_dir,
+              int num_jobs, deweight::WeightFormat weight_format,
+              const deweight::ReductionOptions &options,
+              const std::string &stats_path) {
+  std::vector<std::string> inputs;
+  if (!list_inputs(list, &inputs)) {
+    std::cerr << "Error: Unable to read " << list << "." << std::endl;
+    return -1;
+  }
+  // Jobs must not write to the same file
+  std::vector<std::string> outputs;
+  std::map<std::string, size_t> written_by;
+  for (size_t i = 0; i < inputs.size(); i++) {
+    outputs.push_back(output_path(inputs[i], out_dir));
+    auto inserted = written_by.emplace(outputs[i], i);
+    if (!inserted.second) {
+      std::cerr << "Error: " << inputs[inserted.first->second] << " and "
+                << inputs[i] << " would both be written to " << outputs[i]
+                << "." << std::endl;
+      return -1;
     }
-
-    // -var -> [neg weight] solutions
-    for (int i = 0; i < bits_needed; i++) {
-      vars[i] = -vars[i];  // start counting from the lexicographic bottom
+  }
+  if (mkdir(out_dir.c_str(), 0777) != 0 && errno != EEXIST) {
+    std::cerr << "Error: Unable to create " << out_dir << "." << std::endl;
+    return -1;
+  }
+  FILE *lines = stdout;
+  if (!stats_path.empty()) {
+    lines = fopen(stats_path.c_str(), "w");
+    if (lines == nullptr) {
+      std::cerr << "Error: Unable to write " << stats_path << "."
+                << std::endl;
+      return -1;
     }
-    for (auto &clause : chain_formula(vars, approx.complement().num)) {
-      clause.insert(clause.begin(), var);
-      formula->add_clause(clause);
+  }
+
+  std::atomic<size_t> next(0);
+  std::atomic<size_t> failures(0);
+  std::mutex lines_mutex;
+  auto job = [&]() {
+    DimacsWriter output(-1);
+    InputBuffers buffers;
+    // Each file is reduced on the thread of its job
+    deweight::ThreadPool inline_pool(1);
+    for (size_t i = next++; i < inputs.size(); i = next++) {
+      deweight::Stats stats(true);
+      if (!reduce_file(inputs[i], outputs[i], weight_format, options,
+                       &output, &buffers, &inline_pool, &stats)) {
+        failures++;
+      }
+      std::lock_guard<std::mutex> lock(lines_mutex);
+      stats.write_line(lines);
+      fflush(lines);
     }
+  };
+  deweight::ThreadPool pool(num_jobs);
+  std::vector<std::future<void>> pending;
+  for (size_t i = 0; i < std::min(pool.size(), inputs.size()); i++) {
+    pending.push_back(pool.submit(job));
+  }
+  for (auto &result : pending) {
+    result.get();
+  }
 
-    result *= approx.denom;
+  if (lines != stdout && fclose(lines) != 0) {
+    std::cerr << "Error: Unable to write " << stats_path << "." << std::endl;
+    return -1;
+  }
+  if (failures > 0) {
+    std::cerr << "Error: " << failures << " of " << inputs.size()
+              << " files could not be reduced." << std::endl;
+    return -1;
   }
-  return result;
+  return 0;
 }
 
 int main(int argc, char *argv[]) {
   cxxopts::Options options("deweight",
     "A tool to reduce discrete integration to unweighted model counting.");
-  options.custom_help("[OPTION...] < [WEIGHTED CNF FILE]");
+  options.custom_help("[OPTION...] [WEIGHTED CNF FILE]");
+  options.positional_help("");
   options.add_options()
     ("d, dyadic", "Use dyadic reduction with "
     "[arg] bits per weight.", cxxopts::value<int>())
@@ -246,7 +396,30 @@ int main(int argc, char *argv[]) {
      "--weights=minic2d\tParse miniC2D weights\n"
      "--weights=mc20\tParse weights from MC 2020 competition\n",
      cxxopts::value<deweight::WeightFormat>()->default_value("detect"))
-    ("h, help", "Print usage");
+    ("f, factored", "Output the denominator as prime powers instead of "
+     "expanding it.")
+    ("s, stream", "Write clauses as they are parsed and patch the header "
+     "afterwards. Requires the output to be a regular file.")
+    ("z, compress", "Compress the output with [arg] (gz, xz or zst).",
+     cxxopts::value<std::string>())
+    ("t, threads", "Number of threads to use (0 for one per core).",
+     cxxopts::value<int>()->default_value("0"))
+    ("v, verbose", "Print statistics about the output and memory use to "
+     "stderr.")
+    ("stats", "Write the time taken by each phase and counts describing "
+     "the reduction as JSON to [arg].", cxxopts::value<std::string>())
+    ("batch", "Reduce every file in the directory [arg], or every file "
+     "listed in [arg] (one per line), into --out-dir. --stats then gives a "
+     "line of statistics per file (stdout by default).",
+     cxxopts::value<std::string>())
+    ("out-dir", "Directory to write the files reduced by --batch to.",
+     cxxopts::value<std::string>())
+    ("j, jobs", "Number of files to reduce at once in --batch mode (0 for "
+     "one per core).", cxxopts::value<int>()->default_value("0"))
+    ("h, help", "Print usage")
+    ("input", "Weighted CNF file to read instead of stdin.",
+     cxxopts::value<std::string>());
+  options.parse_positional({"input"});
   auto args = options.parse(argc, argv);
   if (args.count("help")) {
     std::cout << options.help() << std::endl;
@@ -254,28 +427,223 @@ int main(int argc, char *argv[]) {
   }
 
   auto start_time = std::chrono::steady_clock::now();
-  StreamBuffer<FILE*, FN> in = StreamBuffer<FILE*, FN>(stdin);
+  std::unique_ptr<deweight::Stats> stats;
+  if (args.count("stats") > 0) {
+    stats.reset(new deweight::Stats());
+  }
+
+  // Bits per weight for the dyadic reduction, or 0 for the general one
+  int dyadic_bits = 0;
+  if (args.count("dyadic") > 0) {
+    dyadic_bits = args["dyadic"].as<int>();
+    if (dyadic_bits < 1 || dyadic_bits > deweight::kMaxDyadicBits) {
+      std::cerr << "Error: --dyadic must be between 1 and "
+                << deweight::kMaxDyadicBits << "." << std::endl;
+      return -1;
+    }
+  }
+
+  if (args.count("batch") > 0) {
+    if (args.count("out-dir") == 0) {
+      std::cerr << "Error: --batch requires --out-dir." << std::endl;
+      return -1;
+    }
+    if (args.count("input") > 0 || args["stream"].as<bool>()
+        || args.count("compress") > 0) {
+      std::cerr << "Error: --batch cannot be combined with an input file, "
+                << "--stream or --compress." << std::endl;
+      return -1;
+    }
+    deweight::ReductionOptions reduction_options;
+    reduction_options.dyadic_bits = dyadic_bits;
+    reduction_options.rounding =
+      args["rounding"].as<deweight::RoundingStrategy>();
+    reduction_options.factored = args["factored"].as<bool>();
+    int num_jobs = args["jobs"].as<int>();
+    if (num_jobs < 0) {
+      std::cerr << "Error: --jobs must be 0 or higher." << std::endl;
+      return -1;
+    } else if (num_jobs == 0) {
+      num_jobs = std::max(1u, std::thread::hardware_concurrency());
+    }
+    return run_batch(args["batch"].as<std::string>(),
+                     args["out-dir"].as<std::string>(), num_jobs,
+                     args["weights"].as<deweight::WeightFormat>(),
+                     reduction_options,
+                     args.count("stats") > 0 ? args["stats"].as<std::string>()
+                                             : "");
+  }
+
+  int num_threads = args["threads"].as<int>();
+  if (num_threads < 0) {
+    std::cerr << "Error: --threads must be 0 or higher." << std::endl;
+    return -1;
+  } else if (num_threads == 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  // Map the input file if possible; otherwise stream and decompress it
+  MappedFile input;
+  FILE *stream = stdin;
+  std::unique_ptr<FILE, decltype(&fclose)> opened(nullptr, &fclose);
+  if (args.count("input") > 0) {
+    std::string path = args["input"].as<std::string>();
+    if (!input.open(path)
+        || detectCompression(input.data(), input.size()) != Compression::none) {
+      input.close();
+      opened.reset(fopen(path.c_str(), "rb"));
+      if (opened == nullptr) {
+        std::cerr << "Error: Unable to open " << path << "." << std::endl;
+        return -1;
+      }
+      stream = opened.get();
+    }
+  }
+
+  // Compress the output if requested
+  Compression output_format = Compression::none;
+  if (args.count("compress") > 0) {
+    std::string name = args["compress"].as<std::string>();
+    if (!parseCompression(name, output_format)
+        || !compressionSupported(output_format)) {
+      std::cerr << "Error: Unsupported output compression " << name << "."
+                << std::endl;
+      return -1;
+    }
+  }
+  std::unique_ptr<CompressingStreambuf> compressor;
+  std::unique_ptr<std::ostream> compressed;
+  std::unique_ptr<DimacsWriter> output;
+  if (output_format != Compression::none) {
+    compressor.reset(new CompressingStreambuf(STDOUT_FILENO, output_format));
+    compressed.reset(new std::ostream(compressor.get()));
+    output.reset(new DimacsWriter(compressed.get()));
+  } else {
+    output.reset(new DimacsWriter(STDOUT_FILENO));
+    // Passthrough clauses are taken from the mapped input, which is never
+    // modified, so they can be spliced into a pipe
+    if (input.isOpen()) {
+      output->enableSplice();
+    }
+  }
+  bool verbose = args["verbose"].as<bool>();
+
+  // In streaming mode, reserve space for the header and fill it in last
+  DimacsWriter *passthrough = nullptr;
+  off_t header_offset = 0;
+  if (args["stream"].as<bool>()) {
+    if (output_format == Compression::none && is_patchable(STDOUT_FILENO)) {
+      passthrough = output.get();
+      header_offset = lseek(STDOUT_FILENO, 0, SEEK_CUR);
+      output->write("p cnf " + std::string(kHeaderWidth, ' ') + "\n");
+    } else {
+      std::cerr << "Warning: --stream requires the output to be an "
+                << "uncompressed regular file; buffering the formula instead."
+                << std::endl;
+    }
+  }
+
+  deweight::ThreadPool pool(num_threads);
+  // Write the output on its own thread, so that it overlaps with parsing
+  // (when streaming) and with formatting the clauses
+  if (pool.size() > 1) {
+    output->startBackground();
+  }
   auto weight_format = args["weights"].as<deweight::WeightFormat>();
-  auto formula = deweight::Formula(&in, weight_format);
-  if (formula.num_variables() == 0) {
+  std::unique_ptr<deweight::Formula> formula;
+  size_t bytes_in = 0;
+  // Whether a compressed input turned out to be corrupt or truncated
+  bool read_failed = false;
+  {
+    deweight::Stats::Timer timer(stats.get(), deweight::Stats::parse);
+    if (input.isOpen()) {
+      MemoryBuffer in(input.data(), input.size());
+      formula.reset(
+        new deweight::Formula(&in, weight_format, passthrough, &pool));
+      bytes_in = input.size();
+    } else {
+      InputStream decoder(stream);
+      StreamBuffer<InputStream*, IS> in(&decoder);
+      formula.reset(new deweight::Formula(&in, weight_format, passthrough));
+      bytes_in = decoder.bytesRead();
+      read_failed = decoder.failed();
+    }
+  }
+  opened.reset();
+  if (read_failed || formula->num_variables() == 0) {
     std::cerr << "Error: Unable to read formula." << std::endl;
     return -1;
   }
+  int num_variables = formula->num_variables();
+  size_t num_clauses = formula->num_clauses();
 
-  BigInt denom;
-  if (args.count("dyadic") > 0) {
-    int num_bits = args["dyadic"].as<int>();
+  deweight::Denominator denom(args["factored"].as<bool>());
+  track_memory(deweight::Stats::parse, *formula, denom, stats.get(), verbose);
+  deweight::GadgetCache gadgets;
+  if (dyadic_bits > 0) {
     auto rounding = args["rounding"].as<deweight::RoundingStrategy>();
-    denom = reduce_dyadic(&formula, num_bits, rounding);
+    deweight::reduce_dyadic(formula.get(), dyadic_bits, rounding, &gadgets,
+                            &denom, &pool, stats.get());
   } else {
-    denom = reduce(&formula);
+    deweight::reduce(formula.get(), &gadgets, &denom, &pool, stats.get());
   }
+  track_memory(deweight::Stats::reduction, *formula, denom, stats.get(),
+               verbose);
 
-  std::cout << "c denom " << denom << std::endl;
-  auto elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(
-    std::chrono::steady_clock::now() - start_time).count();
-  std::cout << "c deweight time " << elapsed << "\n";
-  formula.write(&std::cout);
+  std::string denom_comments;
+  {
+    deweight::Stats::Timer timer(stats.get(), deweight::Stats::denominator);
+    denom_comments = format_denominator(denom, &pool, stats.get());
+  }
+  track_memory(deweight::Stats::denominator, *formula, denom, stats.get(),
+               verbose);
+
+  if (passthrough != nullptr) {
+    // Clauses are already written; finish with the trailing comments
+    deweight::Stats::Timer timer(stats.get(), deweight::Stats::write);
+    formula->write_independent_support(output.get());
+    output->write(denom_comments);
+    write_time(start_time, output.get());
+    if (!output->flush()) {
+      std::cerr << "Error: Unable to write output." << std::endl;
+      return -1;
+    }
 
+    std::string counts = std::to_string(formula->num_variables()) + " "
+                         + std::to_string(formula->num_clauses()) + "\nc";
+    counts.resize(kHeaderWidth, ' ');
+    if (pwrite(STDOUT_FILENO, counts.data(), counts.size(),
+               header_offset + 6) != static_cast<ssize_t>(counts.size())) {
+      std::cerr << "Error: Unable to write header." << std::endl;
+      return -1;
+    }
+  } else {
+    deweight::Stats::Timer timer(stats.get(), deweight::Stats::write);
+    output->write(denom_comments);
+    write_time(start_time, output.get());
+    formula->write(output.get());
+
+    if (!output->flush()
+        || (compressor != nullptr && !compressor->finish())) {
+      std::cerr << "Error: Unable to write output." << std::endl;
+      return -1;
+    }
+  }
+  if (verbose) {
+    std::cerr << "Output: " << output->stats() << std::endl;
+    std::cerr << "Gadgets: " << gadgets.size() << " built, " << gadgets.hits()
+              << " reused" << std::endl;
+  }
+  track_memory(deweight::Stats::write, *formula, denom, stats.get(), verbose);
+
+  if (stats != nullptr) {
+    record_counts(*formula, num_variables, num_clauses, gadgets, bytes_in,
+                  output->bytesWritten(), stats.get());
+    std::string path = args["stats"].as<std::string>();
+    if (!stats->write_json(path)) {
+      std::cerr << "Error: Unable to write " << path << "." << std::endl;
+      return -1;
+    }
+  }
   return 0;
 }
@@ -27,66 +27,171 @@ namespace deweight {
     return is;
   }
 
-  Rational Rational::parse(std::string rational) {
+  /**
+   * Set [value] to [value] * 10 + [digit], returning false on overflow.
+   */
+  static bool append_digit(int128 *value, char digit) {
+    return !__builtin_mul_overflow(*value, 10, value)
+           && !__builtin_add_overflow(*value, digit - '0', value);
+  }
+
+  /**
+   * Convert [value] >= 0 to a BigNum.
+   */
+  static BigNum to_big(int128 value) {
+    BigNum result(static_cast<uint64_t>(value >> 64));
+    result *= static_cast<uint64_t>(1) << 32;
+    result *= static_cast<uint64_t>(1) << 32;
+    result += BigNum(static_cast<uint64_t>(value));
+    return result;
+  }
+
+  /**
+   * Parse the decimal or fraction [rational], whose characters have been
+   * checked, exactly into [big]. Returns false if its denominator is 0.
+   */
+  static bool parse_big(const std::string &rational, BigRational *big) {
+    size_t split = rational.find_first_of("./");
+    if (split == std::string::npos) {
+      *big = BigRational(BigNum::parse(rational), BigNum(1));
+    } else if (rational[split] == '/') {
+      *big = BigRational(BigNum::parse(rational.substr(0, split)),
+                         BigNum::parse(rational.substr(split + 1)));
+    } else {
+      std::string digits = rational;
+      digits.erase(split, 1);
+      BigNum denominator(1);
+      for (size_t i = split; i < digits.size(); i++) {
+        denominator *= 10;
+      }
+      *big = BigRational(BigNum::parse(digits), denominator);
+    }
+    return !big->denom.is_zero();
+  }
+
+  /**
+   * Return [numerator]/[denominator] as a fraction of [Int]s, simplifying it
+   * only if it does not fit otherwise. If it still does not fit, it is
+   * stored in [big] (if provided) and 0/0 is returned.
+   */
+  template <typename Int>
+  static BasicRational<Int> narrow(int128 numerator, int128 denominator,
+                                   const std::string &rational,
+                                   BigRational *big) {
+    BasicRational<Int> result(numerator, denominator);
+    if (result.num == numerator && result.denom == denominator) {
+      return result;
+    }
+    WideRational simple = WideRational(numerator, denominator).simplify();
+    result = BasicRational<Int>(simple.num, simple.denom);
+    if (result.num == simple.num && result.denom == simple.denom) {
+      return result;
+    }
+    if (big != nullptr) {
+      *big = BigRational(to_big(simple.num), to_big(simple.denom));
+      return BasicRational<Int>(0, 0);
+    }
+    std::cerr << "Weight out of range: " << rational << "\n";
+    return BasicRational<Int>(1, 0);
+  }
+
+  /**
+   * Finish parsing [rational], whose digits do not fit in 128 bits: check
+   * the rest of it, then parse it exactly into [big] (if provided).
+   */
+  template <typename Int>
+  static BasicRational<Int> parse_overflow(const std::string &rational,
+                                           BigRational *big) {
+    bool fraction = rational.find('/') != std::string::npos;
+    char separator = fraction ? '/' : '.';
+    size_t split = rational.find(separator);
+    for (size_t i = 0; i < rational.size(); i++) {
+      char c = rational[i];
+      if ((c < '0' || c > '9') && i != split) {
+        std::cerr << (fraction ? "Unknown fraction: " : "Unknown decimal: ")
+                  << rational << "\n";
+        return BasicRational<Int>(1, 0);
+      }
+    }
+
+    if (!fraction && split != std::string::npos) {
+      // Trailing zeros of a decimal only scale both parts by 10
+      size_t last = rational.find_last_not_of('0');
+      if (last + 1 < rational.size()) {
+        return BasicRational<Int>::parse(rational.substr(0, last + 1), big);
+      }
+    }
+    if (big == nullptr) {
+      std::cerr << "Weight out of range: " << rational << "\n";
+      return BasicRational<Int>(1, 0);
+    }
+    return parse_big(rational, big) ? BasicRational<Int>(0, 0)
+                                    : BasicRational<Int>(1, 0);
+  }
+
+  template <typename Int>
+  BasicRational<Int> BasicRational<Int>::parse(std::string rational,
+                                               BigRational *big) {
     if (rational.find('/') == std::string::npos) {
-      int numerator = 0;
-      int denominator = 1;
+      int128 numerator = 0;
+      int128 denominator = 1;
       bool seen_decimal = false;
 
       for (char const &c : rational) {
         if (c == '.' && !seen_decimal) {
           seen_decimal = true;
         } else if (c >= '0' && c <= '9') {
-          numerator = (numerator * 10) + (c - '0');
-          if (seen_decimal) {
-            denominator *= 10;
+          if (!append_digit(&numerator, c)
+              || (seen_decimal && !append_digit(&denominator, '0'))) {
+            return parse_overflow<Int>(rational, big);
           }
         } else {
           std::cerr << "Unknown decimal: " << rational << "\n";
-          return Rational(1, 0);
+          return BasicRational(1, 0);
         }
       }
-      return Rational(numerator, denominator);
+      return narrow<Int>(numerator, denominator, rational, big);
     } else {
-      int numerator = 0;
-      int denominator = 0;
+      int128 numerator = 0;
+      int128 denominator = 0;
       bool seen_slash = false;
       for (char const &c : rational) {
         if (c == '/' && !seen_slash) {
           seen_slash = true;
         } else if (c >= '0' && c <= '9') {
-          if (seen_slash) {
-            denominator = (denominator * 10) + (c - '0');
-          } else {
-            numerator = (numerator * 10) + (c - '0');
+          if (!append_digit(seen_slash ? &denominator : &numerator, c)) {
+            return parse_overflow<Int>(rational, big);
           }
         } else {
           std::cerr << "Unknown fraction: " << rational << "\n";
-          return Rational(1, 0);
+          return BasicRational(1, 0);
         }
       }
-      return Rational(numerator, denominator);
+      return narrow<Int>(numerator, denominator, rational, big);
     }
   }
 
-  Rational Rational::round(int new_denom, RoundingStrategy strategy) const {
-    int new_num;
+  template <typename Int>
+  BasicRational<Int> BasicRational<Int>::round(
+      int new_denom, RoundingStrategy strategy) const {
+    int128 scaled = static_cast<int128>(num) * new_denom;
+    Int new_num;
     switch (strategy) {
       case up:
-        new_num = (num * new_denom + denom - 1) / denom;
+        new_num = (scaled + denom - 1) / denom;
         if (new_num == new_denom) {
             new_num--;
         }
-        return Rational(new_num, new_denom);
+        return BasicRational(new_num, new_denom);
       case down:
-        new_num = (num * new_denom) / denom;
+        new_num = scaled / denom;
         if (new_num == 0) {
             new_num++;
         }
-        return Rational(new_num, new_denom);
+        return BasicRational(new_num, new_denom);
       case near:
-        Rational ub = round(new_denom, RoundingStrategy::up);
-        Rational lb = round(new_denom, RoundingStrategy::down);
+        BasicRational ub = round(new_denom, RoundingStrategy::up);
+        BasicRational lb = round(new_denom, RoundingStrategy::down);
         if (std::abs(lb.value() - value()) < std::abs(ub.value() - value())) {
           return lb;
         } else {
@@ -95,12 +200,54 @@ namespace deweight {
     }
   }
 
-  Rational Rational::complement() const {
-    return Rational(denom - num, denom);
+  template <typename Int>
+  BasicRational<Int> BasicRational<Int>::complement() const {
+    return BasicRational(denom - num, denom);
   }
 
-  Rational Rational::simplify() const {
-    int gcd = std::__gcd(num, denom);
-    return Rational(num / gcd, denom / gcd);
+  template <typename Int>
+  BasicRational<Int> BasicRational<Int>::simplify() const {
+    Int divisor = gcd(num, denom);
+    return BasicRational(num / divisor, denom / divisor);
+  }
+
+  BigRational::BigRational(const Rational& other)
+  : num(other.num < 0 ? -static_cast<uint64_t>(other.num)
+                       : static_cast<uint64_t>(other.num)),
+    denom(static_cast<uint64_t>(other.denom)),
+    negative(other.num < 0)
+  { }
+
+  BigRational BigRational::complement() const {
+    // 1 - num/denom, keeping the numerator nonnegative
+    if (negative) {
+      BigNum sum = denom;
+      sum += num;
+      return BigRational(sum, denom);
+    } else if (denom < num) {
+      BigNum difference = num;
+      difference -= denom;
+      return BigRational(difference, denom, true);
+    }
+    BigNum difference = denom;
+    difference -= num;
+    return BigRational(difference, denom);
+  }
+
+  template class BasicRational<int64_t>;
+  template class BasicRational<int128>;
+
+  std::string to_string(int128 value) {
+    uint128 magnitude = value < 0 ? -static_cast<uint128>(value) : value;
+    char digits[40];
+    char *p = digits + sizeof(digits);
+    do {
+      *--p = static_cast<char>('0' + magnitude % 10);
+      magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) {
+      *--p = '-';
+    }
+    return std::string(p, digits + sizeof(digits) - p);
   }
 }  // namespace deweight
@@ -4,40 +4,122 @@ Copyright (c) 2020, Jeffrey Dudek
 
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <string>
+#include <utility>
+
+#include "src/bignum.h"
 
 namespace deweight {
+__extension__ typedef __int128 int128;
+__extension__ typedef unsigned __int128 uint128;
+
 enum RoundingStrategy {up, down, near};
 std::istream& operator>> (std::istream& is, RoundingStrategy& rs);
 
-/** 
- * Represents a weight for a variable.
+struct BigRational;
+
+/**
+ * Represents a weight for a variable as a fraction of two [Int]s.
+ *
+ * Weights are stored as Rational (64-bit). Arithmetic that can overflow
+ * 64 bits is done on a WideRational (128-bit) instead, and weights that do
+ * not fit in 64 bits even when simplified are kept as a BigRational.
  */
-class Rational {
+template <typename Int>
+class BasicRational {
  public:
-  Rational(const Rational& other) = default;
-  Rational& operator=(const Rational& other) = default;
+  BasicRational(const BasicRational& other) = default;
+  BasicRational& operator=(const BasicRational& other) = default;
 
-  explicit Rational(int numerator, int denominator)
+  explicit BasicRational(Int numerator, Int denominator)
   : num(numerator), denom(denominator)
   { }
 
-  Rational complement() const;
-  Rational simplify() const;
+  /**
+   * Widen a fraction of a narrower integer type.
+   */
+  template <typename Narrow>
+  explicit BasicRational(const BasicRational<Narrow>& other)
+  : num(other.num), denom(other.denom)
+  { }
+
+  BasicRational complement() const;
+  BasicRational simplify() const;
   double value() const {
     return static_cast<double>(num) / static_cast<double>(denom);
   }
 
-  Rational round(int new_denom, RoundingStrategy strategy) const;
+  /**
+   * Round to a fraction over [new_denom]; the product of the numerator and
+   * [new_denom] is computed in 128 bits.
+   */
+  BasicRational round(int new_denom, RoundingStrategy strategy) const;
 
-  static Rational parse(std::string decimal);
+  /**
+   * Parse a decimal or a fraction. Digits are accumulated in 128 bits and
+   * the result is simplified if that is needed to fit it in [Int]. Values
+   * that still do not fit are parsed exactly into [big] (if provided) and
+   * returned as 0/0; otherwise they are reported and parsed as 1/0. Invalid
+   * values are reported and parsed as 1/0.
+   */
+  static BasicRational parse(std::string decimal, BigRational *big = nullptr);
 
-  const int num;
-  const int denom;
+  Int num;
+  Int denom;
 };
 
-inline std::string to_string(const Rational& r) {
-    return std::to_string(r.num) + "/" + std::to_string(r.denom);
+typedef BasicRational<int64_t> Rational;
+typedef BasicRational<int128> WideRational;
+
+/**
+ * A weight too large for a Rational, kept exactly as a fraction of BigNums
+ * with a sign. Only the rare weights that need it pay for it.
+ */
+struct BigRational {
+  BigRational() = default;
+  BigRational(BigNum numerator, BigNum denominator, bool is_negative = false)
+  : num(std::move(numerator)), denom(std::move(denominator)),
+    negative(is_negative)
+  { }
+
+  /**
+   * Widen a Rational with a positive denominator.
+   */
+  explicit BigRational(const Rational& other);
+
+  BigRational complement() const;
+
+  BigNum num;
+  BigNum denom = BigNum(1);
+  bool negative = false;
+};
+
+/**
+ * Greatest common divisor of [a] and [b]. 128-bit division is done in
+ * software, so values that fit in 64 bits are divided as such.
+ */
+inline int128 gcd(int128 a, int128 b) {
+  if (a == static_cast<int64_t>(a) && b == static_cast<int64_t>(b)) {
+    return std::__gcd(static_cast<int64_t>(a), static_cast<int64_t>(b));
+  }
+  return std::__gcd(a, b);
+}
+
+/**
+ * Get the decimal representation of [value].
+ */
+std::string to_string(int128 value);
+
+template <typename Int>
+inline std::string to_string(const BasicRational<Int>& r) {
+    return to_string(r.num) + "/" + to_string(r.denom);
+}
+
+inline std::string to_string(const BigRational& r) {
+    return (r.negative ? "-" : "") + r.num.to_string() + "/"
+           + r.denom.to_string();
 }
 }  // namespace deweight
@@ -0,0 +1,562 @@
+/******************************************
+Copyright (c) 2020, Jeffrey Dudek
+******************************************/
+
+#include "src/reduction.h"
+
+#include <algorithm>
+#include <future>
+#include <iostream>
+#include <memory>
+
+namespace deweight {
+  // Number of variables reduced together. Batches bound the clauses held at
+  // once when streaming.
+  static const size_t kReduceBatch = 1 << 16;
+  // Fewest variables worth handing to another thread
+  static const size_t kMinVarsPerTask = 1 << 10;
+
+  /**
+   * Counts for a variable whose weights do not fit in a Rational.
+   */
+  struct BigCounts {
+    BigNum pos_sol;
+    BigNum neg_sol;
+    BigNum denom;
+  };
+
+  /**
+   * How one variable is reduced.
+   */
+  struct Reduction {
+    int var = 0;
+    // Why the variable is skipped, if it is
+    const char *skipped = nullptr;
+    // Arguments of the GadgetCache lookup for the gadget, if one is needed
+    bool has_gadget = false;
+    uint128 key_first = 0;
+    uint128 key_second = 0;
+    // Factor of the normalizing denominator, split in two if it does not fit
+    // in 64 bits
+    uint64_t denom = 1;
+    uint64_t denom_cofactor = 1;
+    // Whether the weight was rounded, and to what
+    bool adjusted = false;
+    WideRational weight = WideRational(1, 1);
+    WideRational approx = WideRational(1, 1);
+    // Used instead of the keys and denom, and instead of weight, for weights
+    // too large for them
+    std::unique_ptr<BigCounts> big_counts;
+    std::unique_ptr<BigRational> big_weight;
+  };
+
+  /**
+   * Plan the reduction of [var] with weights [pos] and [neg], at least one
+   * of which does not fit in a Rational. The counts are exact.
+   */
+  static Reduction plan_big(int var, const BigRational &pos,
+                            const BigRational &neg) {
+    Reduction reduction;
+    reduction.var = var;
+    if (pos.negative || neg.negative) {
+      reduction.skipped = "negative weight";
+      return reduction;
+    }
+
+    // Ensure both weights have identical denominators
+    std::unique_ptr<BigCounts> counts(new BigCounts());
+    counts->pos_sol = pos.num;
+    counts->neg_sol = neg.num;
+    counts->denom = pos.denom;
+    if (pos.denom != neg.denom) {
+      counts->pos_sol *= neg.denom;
+      counts->neg_sol *= pos.denom;
+      counts->denom *= neg.denom;
+    }
+
+    // Simplify weights, as for those that fit
+    BigNum divisor = gcd(gcd(counts->pos_sol, counts->neg_sol), counts->denom);
+    if (divisor != BigNum(1)) {
+      counts->pos_sol.divide(divisor);
+      counts->neg_sol.divide(divisor);
+      counts->denom.divide(divisor);
+    }
+    reduction.has_gadget = true;
+    reduction.big_counts = std::move(counts);
+    return reduction;
+  }
+
+  /**
+   * Return |[a] - [b]|.
+   */
+  static BigNum distance(const BigNum &a, const BigNum &b) {
+    BigNum result = a < b ? b : a;
+    result -= a < b ? a : b;
+    return result;
+  }
+
+  /**
+   * Round the nonnegative [weight] to a fraction over 2^[bits] (at most 30)
+   * as BasicRational::round does, exactly.
+   */
+  static Rational round_big(const BigRational &weight, int bits,
+                            RoundingStrategy strategy) {
+    const int64_t new_denom = static_cast<int64_t>(1) << bits;
+    BigNum scaled = weight.num;
+    scaled *= static_cast<uint64_t>(new_denom);
+    auto times = [&weight](int64_t count) {
+      BigNum product = weight.denom;
+      product *= static_cast<uint64_t>(count);
+      return product;
+    };
+
+    // Find the rounded down numerator, which is at most new_denom for
+    // weights up to 1, by binary search
+    int64_t low = 0;
+    int64_t high = new_denom;
+    if (times(high) < scaled) {
+      low = high;
+    }
+    while (low < high) {
+      int64_t mid = low + (high - low + 1) / 2;
+      if (scaled < times(mid)) {
+        high = mid - 1;
+      } else {
+        low = mid;
+      }
+    }
+
+    int64_t down = low == 0 ? 1 : low;
+    int64_t up = times(low) == scaled ? low : low + 1;
+    if (up == new_denom) {
+      up--;
+    }
+    switch (strategy) {
+      case RoundingStrategy::up:
+        return Rational(up, new_denom);
+      case RoundingStrategy::down:
+        return Rational(down, new_denom);
+      default:
+        if (distance(times(down), scaled) < distance(times(up), scaled)) {
+          return Rational(down, new_denom);
+        }
+        return Rational(up, new_denom);
+    }
+  }
+
+  /**
+   * Run [task](begin, end) over ranges covering [0, size) on [pool], and wait
+   * for all of them.
+   */
+  template <typename Task>
+  static void parallel_for(size_t size, ThreadPool *pool, Task task) {
+    size_t num_tasks = std::min(pool->size(), size / kMinVarsPerTask);
+    if (num_tasks <= 1) {
+      task(0, size);
+      return;
+    }
+    std::vector<std::future<void>> pending;
+    for (size_t i = 0; i < num_tasks; i++) {
+      size_t begin = size * i / num_tasks;
+      size_t end = size * (i + 1) / num_tasks;
+      pending.push_back(pool->submit([&task, begin, end]() {
+        task(begin, end);
+      }));
+    }
+    for (auto &result : pending) {
+      result.get();
+    }
+  }
+
+  /**
+   * Add clauses to [formula] that capture the weight of every free variable,
+   * as decided for each variable by [plan].
+   *
+   * Variables are planned in parallel on [pool]. Gadgets (found by [lookup]
+   * from a Reduction), auxiliary variables and space for the clauses are
+   * then allocated in order, so the clauses of each variable can be written in
+   * parallel and the output matches reducing one variable at a time. The
+   * normalizing factor of the new formula is accumulated in [net_denom].
+   *
+   * Planning is timed as weight resolution in [stats] (if provided). Rounded
+   * weights are appended to [adjustments] (if provided).
+   */
+  template <typename Plan, typename Lookup>
+  static void reduce_variables(
+    Formula *formula,
+    Plan plan,
+    Lookup lookup,
+    Denominator *net_denom,
+    ThreadPool *pool,
+    Stats *stats,
+    std::vector<Adjustment> *adjustments) {
+    std::vector<int> free_variables = formula->get_independent_support();
+    // If there is no independent support, consider all variables
+    if (free_variables.size() == 0) {
+      for (int var = 1; var <= formula->num_variables(); var++) {
+        free_variables.push_back(var);
+      }
+    }
+
+    std::vector<Reduction> reductions;
+    std::vector<const Gadget *> chosen;
+    std::vector<int> first_aux;
+    std::vector<size_t> offsets;
+    // Reused for every comment
+    std::string comment;
+    for (size_t batch = 0; batch < free_variables.size();
+         batch += kReduceBatch) {
+      size_t size = std::min(kReduceBatch, free_variables.size() - batch);
+      const int *vars = free_variables.data() + batch;
+
+      reductions.resize(size);
+      {
+        Stats::Timer timer(stats, Stats::weights);
+        parallel_for(size, pool, [&](size_t begin, size_t end) {
+          for (size_t i = begin; i < end; i++) {
+            reductions[i] = plan(vars[i]);
+          }
+        });
+      }
+
+      // Allocate gadgets, auxiliary variables and clauses in order
+      chosen.assign(size, nullptr);
+      first_aux.resize(size);
+      offsets.resize(size);
+      size_t num_literals = 0;
+      {
+        Stats::Timer timer(stats, Stats::reduction);
+        for (size_t i = 0; i < size; i++) {
+          const Reduction &reduction = reductions[i];
+          if (reduction.skipped != nullptr) {
+            std::cerr << "Skipping var " << reduction.var << " ("
+                      << reduction.skipped << ")" << std::endl;
+            continue;
+          }
+          if (reduction.has_gadget) {
+            const Gadget &gadget = lookup(reduction);
+            chosen[i] = &gadget;
+            first_aux[i] = formula->num_variables() + 1;
+            for (size_t j = 0; j < gadget.num_aux(); j++) {
+              size_t aux = formula->add_variable();
+              if (formula->has_independent_support()) {
+                formula->add_independent_support(aux);
+              }
+            }
+            offsets[i] = num_literals;
+            num_literals += gadget.num_literals();
+          }
+        }
+      }
+
+      {
+        Stats::Timer timer(stats, Stats::denominator);
+        for (const Reduction &reduction : reductions) {
+          if (reduction.skipped != nullptr) {
+            continue;
+          } else if (reduction.big_counts != nullptr) {
+            net_denom->multiply(reduction.big_counts->denom);
+            continue;
+          }
+          net_denom->multiply(reduction.denom);
+          if (reduction.denom_cofactor != 1) {
+            net_denom->multiply(reduction.denom_cofactor);
+          }
+        }
+      }
+
+      Stats::Timer timer(stats, Stats::reduction);
+      int *clauses = formula->reserve_clauses(num_literals);
+      parallel_for(size, pool, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+          if (chosen[i] != nullptr) {
+            chosen[i]->instantiate(vars[i], first_aux[i],
+                                   clauses + offsets[i]);
+          }
+        }
+      });
+
+      // Add each variable's comment and clauses in order
+      for (size_t i = 0; i < size; i++) {
+        const Reduction &reduction = reductions[i];
+        if (reduction.skipped != nullptr) {
+          continue;
+        }
+        if (reduction.adjusted) {
+          comment.assign("adjust w ");
+          comment.append(std::to_string(reduction.var));
+          comment.push_back(' ');
+          if (reduction.big_weight != nullptr) {
+            comment.append(to_string(*reduction.big_weight));
+          } else {
+            comment.append(to_string(reduction.weight));
+          }
+          comment.append(" to ");
+          comment.append(to_string(reduction.approx));
+          formula->add_comment(comment);
+          // Weights too large for a Rational only come from parsed formulas
+          if (adjustments != nullptr && reduction.big_weight == nullptr) {
+            // Dyadic weights are simplified 64-bit weights, so they fit
+            adjustments->push_back({
+              reduction.var,
+              Rational(reduction.weight.num, reduction.weight.denom),
+              Rational(reduction.approx.num, reduction.approx.denom)});
+          }
+        }
+        if (chosen[i] != nullptr) {
+          formula->add_clauses(chosen[i]->num_literals(),
+                               chosen[i]->num_clauses());
+        }
+      }
+    }
+  }
+
+  void reduce(Formula *formula, GadgetCache *gadgets, Denominator *net_denom,
+              ThreadPool *pool, Stats *stats) {
+    auto plan = [formula](int var) {
+      if (formula->has_big_weight(var) || formula->has_big_weight(-var)) {
+        return plan_big(var, formula->get_big_weight(var),
+                        formula->get_big_weight(-var));
+      }
+      Reduction reduction;
+      reduction.var = var;
+      // Cross-multiplied 64-bit weights always fit in 128 bits
+      WideRational pos(formula->get_weight(var));
+      WideRational neg(formula->get_weight(-var));
+
+      // Ensure both weights have identical denominators
+      int128 pos_sol, neg_sol, denom;
+      if (pos.denom == neg.denom) {
+        pos_sol = pos.num;
+        neg_sol = neg.num;
+        denom = pos.denom;
+      } else {
+        pos_sol = pos.num * neg.denom;
+        neg_sol = neg.num * pos.denom;
+        denom = pos.denom * neg.denom;
+      }
+
+      // Simplify weights if possible (invalid weights such as 0/0 give a
+      // gcd of 0)
+      int128 gcd = deweight::gcd(pos_sol, neg_sol);
+      gcd = deweight::gcd(gcd, denom);
+      if (gcd != 0) {
+        pos_sol /= gcd;
+        neg_sol /= gcd;
+        denom /= gcd;
+      }
+
+      if (pos_sol < 0 || neg_sol < 0) {
+        reduction.skipped = "negative weight";
+        return reduction;
+      }
+
+      // Use a gadget so that:
+      //   var  -> pos_sol solutions
+      //   -var -> neg_sol solutions
+      reduction.has_gadget = true;
+      reduction.key_first = pos_sol;
+      reduction.key_second = neg_sol;
+      reduction.denom = denom;
+      if (reduction.denom != denom) {
+        // [denom] divides pos.denom * neg.denom, so it is the product of a
+        // factor of each
+        int128 factor = deweight::gcd(denom, pos.denom);
+        reduction.denom = factor;
+        reduction.denom_cofactor = denom / factor;
+      }
+      return reduction;
+    };
+    auto lookup = [gadgets](const Reduction &reduction)
+        -> const Gadget & {
+      if (reduction.big_counts != nullptr) {
+        return gadgets->reduction(reduction.big_counts->pos_sol,
+                                  reduction.big_counts->neg_sol);
+      }
+      return gadgets->reduction(reduction.key_first, reduction.key_second);
+    };
+    reduce_variables(formula, plan, lookup, net_denom, pool, stats, nullptr);
+  }
+
+  void reduce_dyadic(
+    Formula *formula,
+    int bits_per_var,
+    RoundingStrategy rounding,
+    GadgetCache *gadgets,
+    Denominator *net_denom,
+    ThreadPool *pool,
+    Stats *stats,
+    std::vector<Adjustment> *adjustments) {
+    auto plan = [formula, bits_per_var, rounding](int var) {
+      Reduction reduction;
+      reduction.var = var;
+      WideRational approx(1, 1);
+      if (formula->has_big_weight(var) || formula->has_big_weight(-var)) {
+        BigRational pos = formula->get_big_weight(var);
+        BigRational neg = formula->get_big_weight(-var);
+        if (pos.negative || neg.negative) {
+          reduction.skipped = "negative weight";
+          return reduction;
+        }
+
+        // pos + neg = 1 when pos.num * neg.denom + neg.num * pos.denom
+        // = pos.denom * neg.denom
+        BigNum sum = pos.num;
+        sum *= neg.denom;
+        BigNum neg_part = neg.num;
+        neg_part *= pos.denom;
+        sum += neg_part;
+        BigNum product = pos.denom;
+        product *= neg.denom;
+        if (sum != product) {
+          reduction.skipped = "non-probabilistic weights";
+          return reduction;
+        }
+
+        approx = WideRational(round_big(pos, bits_per_var, rounding))
+          .simplify();
+        reduction.big_weight.reset(new BigRational(pos));
+      } else {
+        WideRational pos(formula->get_weight(var).simplify());
+        WideRational neg(formula->get_weight(-var).simplify());
+
+        if (pos.denom != neg.denom || pos.num + neg.num != pos.denom) {
+          reduction.skipped = "non-probabilistic weights";
+          return reduction;
+        }
+
+        if (pos.num < 0 || neg.num < 0) {
+          reduction.skipped = "negative weight";
+          return reduction;
+        }
+
+        if (pos.num == 1 && neg.num == 1 && pos.denom == 1) {
+          reduction.denom = 2;
+          return reduction;  // No need to modify unweighted variables.
+        }
+
+        // Round the weight to the nearest dyadic weight
+        // (rounding the positive weight down)
+        approx = pos.round(1 << bits_per_var, rounding).simplify();
+        reduction.weight = pos;
+      }
+
+      int bits_needed = 0;
+      while ((1 << bits_needed) < approx.denom) {
+        bits_needed++;
+      }
+      reduction.adjusted = true;
+      reduction.approx = approx;
+
+      if (approx.num == 1 && approx.denom == 2) {
+        // No need to include any variables for weights (1/2, 1/2)
+        reduction.denom = 2;
+        return reduction;
+      }
+
+      if (approx.denom == 1) {
+        // Weights (1, 0) need no clauses and weights (0, 1) only the unit
+        // clause -var, from the gadget over no auxiliary variables
+        reduction.denom = 1;
+        if (approx.num == 0) {
+          reduction.has_gadget = true;
+          reduction.key_first = 0;
+          reduction.key_second = 0;
+        }
+        return reduction;
+      }
+
+      // Use a chain formula gadget
+      reduction.has_gadget = true;
+      reduction.key_first = approx.num;
+      reduction.key_second = bits_needed;
+      reduction.denom = approx.denom;
+      return reduction;
+    };
+    auto lookup = [gadgets](const Reduction &reduction)
+        -> const Gadget & {
+      return gadgets->dyadic(static_cast<int>(reduction.key_first),
+                             static_cast<int>(reduction.key_second));
+    };
+    reduce_variables(formula, plan, lookup, net_denom, pool, stats,
+                     adjustments);
+  }
+
+  bool reduce_weighted(int num_variables, const int *literals,
+                       size_t num_literals, const int *weighted,
+                       const Rational *weights, size_t num_weights,
+                       const int *independent_support, size_t support_size,
+                       const ReductionOptions &options, ThreadPool *pool,
+                       ReductionResult *result) {
+    if (num_variables < 0) {
+      std::cerr << "Error: The number of variables must be 0 or higher."
+                << std::endl;
+      return false;
+    }
+    if (options.dyadic_bits < 0 || options.dyadic_bits > kMaxDyadicBits) {
+      std::cerr << "Error: The dyadic reduction needs 1 to " << kMaxDyadicBits
+                << " bits per weight." << std::endl;
+      return false;
+    }
+    Formula formula(num_variables);
+
+    // Check the clauses, then copy them in at once
+    size_t num_clauses = 0;
+    for (size_t i = 0; i < num_literals; i++) {
+      if (literals[i] == 0) {
+        num_clauses++;
+      } else if (!formula.is_valid_literal(literals[i])) {
+        std::cerr << "Error: Literal " << literals[i] << " of clause "
+                  << num_clauses << " is not in the formula." << std::endl;
+        return false;
+      }
+    }
+    if (num_literals > 0 && literals[num_literals - 1] != 0) {
+      std::cerr << "Error: The last clause does not end with 0." << std::endl;
+      return false;
+    }
+    std::copy(literals, literals + num_literals,
+              formula.reserve_clauses(num_literals));
+    formula.add_clauses(num_literals, num_clauses);
+
+    for (size_t i = 0; i < num_weights; i++) {
+      if (!formula.is_valid_literal(weighted[i]) || weights[i].denom <= 0
+          || weights[i].num < 0) {
+        std::cerr << "Error: Invalid weight " << to_string(weights[i])
+                  << " for literal " << weighted[i] << "." << std::endl;
+        return false;
+      }
+      formula.set_weight(weighted[i], weights[i]);
+    }
+    for (size_t i = 0; i < support_size; i++) {
+      if (independent_support[i] <= 0
+          || !formula.is_valid_literal(independent_support[i])) {
+        std::cerr << "Error: Variable " << independent_support[i]
+                  << " of the independent support is not in the formula."
+                  << std::endl;
+        return false;
+      }
+      formula.add_independent_support(independent_support[i]);
+    }
+
+    GadgetCache gadgets;
+    Denominator denom(options.factored);
+    result->adjustments.clear();
+    if (options.dyadic_bits > 0) {
+      reduce_dyadic(&formula, options.dyadic_bits, options.rounding,
+                    &gadgets, &denom, pool, nullptr, &result->adjustments);
+    } else {
+      reduce(&formula, &gadgets, &denom, pool);
+    }
+
+    result->num_variables = formula.num_variables();
+    result->num_clauses = formula.num_clauses();
+    result->clauses = formula.release_clauses();
+    if (options.factored) {
+      result->denominator = denom.factors();
+    } else {
+      result->denominator = denom.value(pool).to_string(pool);
+    }
+    return true;
+  }
+}  // namespace deweight
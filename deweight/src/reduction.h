@@ -0,0 +1,108 @@
+/******************************************
+Copyright (c) 2020, Jeffrey Dudek
+******************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "src/denominator.h"
+#include "src/formula.h"
+#include "src/gadget.h"
+#include "src/rational.h"
+#include "src/stats.h"
+#include "src/thread_pool.h"
+
+namespace deweight {
+// Most bits per weight the dyadic reduction can use
+const int kMaxDyadicBits = 30;
+
+/**
+ * A weight rounded by the dyadic reduction: the positive literal of [var]
+ * had [weight] and is reduced with weight [approx].
+ */
+struct Adjustment {
+  int var;
+  Rational weight;
+  Rational approx;
+};
+
+/**
+ * Add clauses to [formula] so that all weights are captured in the clauses.
+ *
+ * Gadgets are shared through [gadgets]. The normalizing factor of the new
+ * formula is accumulated in [net_denom]. Phases are timed in [stats] (if
+ * provided).
+ */
+void reduce(Formula *formula, GadgetCache *gadgets, Denominator *net_denom,
+            ThreadPool *pool, Stats *stats = nullptr);
+
+/**
+ * Using the dyadic reduction, add clauses to [formula] so that all weights are
+ * captured in the clauses.
+ *
+ * The denominators of weights must be powers of 2. All weights are rounded
+ * to the nearest factor of 1/2^[bits_per_var] (rounding positive weight down),
+ * where 1 <= [bits_per_var] <= kMaxDyadicBits.
+ *
+ * Gadgets are shared through [gadgets]. The normalizing factor of the new
+ * formula is accumulated in [net_denom]. Phases are timed in [stats] (if
+ * provided). Each rounded weight is added to the formula as an "adjust w"
+ * comment and, if [adjustments] is provided, appended to it.
+ */
+void reduce_dyadic(Formula *formula, int bits_per_var,
+                   RoundingStrategy rounding, GadgetCache *gadgets,
+                   Denominator *net_denom, ThreadPool *pool,
+                   Stats *stats = nullptr,
+                   std::vector<Adjustment> *adjustments = nullptr);
+
+/**
+ * How reduce_weighted reduces a formula.
+ */
+struct ReductionOptions {
+  // Bits per weight for the dyadic reduction (at most kMaxDyadicBits), or 0
+  // for the general reduction
+  int dyadic_bits = 0;
+  RoundingStrategy rounding = RoundingStrategy::down;
+  // Give the denominator as prime powers instead of expanding it
+  bool factored = false;
+};
+
+/**
+ * An unweighted formula produced by reduce_weighted.
+ */
+struct ReductionResult {
+  int num_variables = 0;
+  size_t num_clauses = 0;
+  // Literals of the clauses, each clause ending with 0
+  std::vector<int> clauses;
+  // The normalizing factor in decimal, or as "p1^e1 p2^e2 ..." if factored
+  // (followed by " * c1^f1 ..." for composites that could not be split)
+  std::string denominator;
+  // Weights rounded by the dyadic reduction, in the order they were reduced
+  std::vector<Adjustment> adjustments;
+};
+
+/**
+ * Reduce a weighted CNF held in memory, without going through DIMACS.
+ *
+ * The formula has [num_variables] variables and the clauses in [literals]
+ * (of which there are [num_literals]), each ending with 0. Literal
+ * [weighted][i] has weight [weights][i] for i < [num_weights]; literals
+ * without a weight have weight 1, as in the MC 2020 format. If
+ * [independent_support] is provided, only its [support_size] variables are
+ * reduced.
+ *
+ * Returns false (after reporting why to stderr) if the formula or the
+ * options are invalid. Weights must be nonnegative, since the reduction
+ * cannot capture a negative weight.
+ */
+bool reduce_weighted(int num_variables, const int *literals,
+                     size_t num_literals, const int *weighted,
+                     const Rational *weights, size_t num_weights,
+                     const int *independent_support, size_t support_size,
+                     const ReductionOptions &options, ThreadPool *pool,
+                     ReductionResult *result);
+}  // namespace deweight
@@ -0,0 +1,162 @@
+/******************************************
+Copyright (c) 2020, Jeffrey Dudek
+******************************************/
+
+#include "src/stats.h"
+
+#include <sys/resource.h>
+#include <time.h>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace deweight {
+  static const char *kPhaseNames[Stats::num_phases] = {
+    "parse", "weights", "reduction", "denominator", "write"
+  };
+
+  Stats::Timer::Timer(Stats *stats, Phase phase)
+    : stats_(stats), phase_(phase) {
+    if (stats_ != nullptr) {
+      wall_start_ = std::chrono::steady_clock::now();
+      cpu_start_ = cpu_time(stats_->thread_cpu_);
+    }
+  }
+
+  Stats::Timer::~Timer() {
+    if (stats_ != nullptr) {
+      double wall = std::chrono::duration_cast<std::chrono::duration<double>>(
+        std::chrono::steady_clock::now() - wall_start_).count();
+      stats_->add_time(phase_, wall,
+                       cpu_time(stats_->thread_cpu_) - cpu_start_);
+      stats_->sample_rss(phase_);
+    }
+  }
+
+  void Stats::set(Values *values, const std::string &name, uint64_t value) {
+    for (auto &entry : *values) {
+      if (entry.first == name) {
+        entry.second = value;
+        return;
+      }
+    }
+    values->emplace_back(name, value);
+  }
+
+  void Stats::set_memory(const std::string &name, uint64_t bytes) {
+    for (auto &entry : memory_) {
+      if (entry.first == name) {
+        entry.second = std::max(entry.second, bytes);
+        return;
+      }
+    }
+    memory_.emplace_back(name, bytes);
+  }
+
+  void Stats::set_string(const std::string &name, const std::string &value) {
+    for (auto &entry : strings_) {
+      if (entry.first == name) {
+        entry.second = value;
+        return;
+      }
+    }
+    strings_.emplace_back(name, value);
+  }
+
+  /**
+   * Write [value] as a JSON string to [file].
+   */
+  static void write_string(FILE *file, const std::string &value) {
+    fputc('"', file);
+    for (char c : value) {
+      if (c == '"' || c == '\\') {
+        fputc('\\', file);
+        fputc(c, file);
+      } else if (static_cast<unsigned char>(c) < 0x20) {
+        fprintf(file, "\\u%04x", c);
+      } else {
+        fputc(c, file);
+      }
+    }
+    fputc('"', file);
+  }
+
+  /**
+   * Write [values] as the members of a JSON object to [file], each after
+   * [indent] and followed by [separator] (or [newline] for the last).
+   */
+  static void write_values(
+      FILE *file, const std::vector<std::pair<std::string, uint64_t>> &values,
+      const char *indent, const char *separator, const char *newline) {
+    for (size_t i = 0; i < values.size(); i++) {
+      fprintf(file, "%s\"%s\": %llu%s", indent, values[i].first.c_str(),
+              static_cast<unsigned long long>(values[i].second),
+              i + 1 < values.size() ? separator : newline);
+    }
+  }
+
+  void Stats::write_object(FILE *file, bool one_line) const {
+    // Line breaks and indentation, unless everything is on one line
+    const char *newline = one_line ? "" : "\n";
+    const char *indent = one_line ? "" : "  ";
+    const char *inner = one_line ? "" : "    ";
+    const char *separator = one_line ? ", " : ",\n";
+    fprintf(file, "{%s", newline);
+    for (const auto &entry : strings_) {
+      fprintf(file, "%s\"%s\": ", indent, entry.first.c_str());
+      write_string(file, entry.second);
+      fputs(separator, file);
+    }
+    fprintf(file, "%s\"phases\": {%s", indent, newline);
+    for (int phase = 0; phase < num_phases; phase++) {
+      fprintf(file, "%s\"%s\": {\"wall\": %.6f, \"cpu\": %.6f, "
+              "\"peak_rss\": %llu}%s", inner,
+              kPhaseNames[phase], wall_[phase], cpu_[phase],
+              static_cast<unsigned long long>(rss_[phase]),
+              phase + 1 < num_phases ? separator : newline);
+    }
+    fprintf(file, "%s}%s%s\"counters\": {%s", indent, separator, indent,
+            newline);
+    write_values(file, counters_, inner, separator, newline);
+    fprintf(file, "%s}%s%s\"memory\": {%s", indent, separator, indent,
+            newline);
+    write_values(file, memory_, inner, separator, newline);
+    fprintf(file, "%s}%s}\n", indent, newline);
+  }
+
+  bool Stats::write_json(const std::string &path) const {
+    FILE *file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+      return false;
+    }
+    write_object(file, false);
+    return fclose(file) == 0;
+  }
+
+  void Stats::write_line(FILE *file) const {
+    write_object(file, true);
+  }
+
+  double Stats::cpu_time(bool thread) {
+    struct timespec now;
+    clockid_t clock = thread ? CLOCK_THREAD_CPUTIME_ID
+                             : CLOCK_PROCESS_CPUTIME_ID;
+    if (clock_gettime(clock, &now) != 0) {
+      return 0;
+    }
+    return now.tv_sec + now.tv_nsec / 1e9;
+  }
+
+  uint64_t Stats::peak_rss() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+      return 0;
+    }
+    // Reported in kilobytes on Linux
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+  }
+
+  const char *Stats::name(Phase phase) {
+    return kPhaseNames[phase];
+  }
+}  // namespace deweight
@@ -0,0 +1,126 @@
+/******************************************
+Copyright (c) 2020, Jeffrey Dudek
+******************************************/
+
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace deweight {
+/**
+ * Collects the wall and CPU time spent in each phase of a run and the peak
+ * RSS at its end, together with counters describing the run and the bytes
+ * held by its main structures, and writes them as JSON (for --stats and
+ * --batch).
+ */
+class Stats {
+ public:
+  enum Phase {parse, weights, reduction, denominator, write, num_phases};
+
+  /**
+   * If [thread_cpu], CPU time is measured for the calling thread only, so
+   * that runs on different threads of the same process can be told apart.
+   */
+  explicit Stats(bool thread_cpu = false) : thread_cpu_(thread_cpu) {}
+
+  /**
+   * Adds the time from its construction to its destruction to [phase] of
+   * [stats] (if provided), and samples the peak RSS when it is destroyed.
+   */
+  class Timer {
+   public:
+    Timer(Stats *stats, Phase phase);
+    ~Timer();
+
+    Timer(const Timer& other) = delete;
+    Timer& operator=(const Timer& other) = delete;
+
+   private:
+    Stats *stats_;
+    Phase phase_;
+    std::chrono::steady_clock::time_point wall_start_;
+    double cpu_start_;
+  };
+
+  void add_time(Phase phase, double wall, double cpu) {
+    wall_[phase] += wall;
+    cpu_[phase] += cpu;
+  }
+
+  void sample_rss(Phase phase) {
+    rss_[phase] = peak_rss();
+  }
+
+  /**
+   * Set the counter [name] to [value]. Counters are written in the order
+   * they were first set.
+   */
+  void set(const std::string &name, uint64_t value) {
+    set(&counters_, name, value);
+  }
+
+  /**
+   * Set the string [name] to [value]. Strings are written before counters,
+   * in the order they were first set.
+   */
+  void set_string(const std::string &name, const std::string &value);
+
+  /**
+   * Record that [bytes] are held by the structure [name], keeping the
+   * largest value recorded for it.
+   */
+  void set_memory(const std::string &name, uint64_t bytes);
+
+  /**
+   * Write the statistics as a JSON object to [path], returning false if
+   * the file cannot be written.
+   */
+  bool write_json(const std::string &path) const;
+
+  /**
+   * Write the statistics as a JSON object on a single line to [file].
+   */
+  void write_line(FILE *file) const;
+
+  /**
+   * Get the CPU time used by all threads of the process (or only by the
+   * calling thread, if [thread]), in seconds.
+   */
+  static double cpu_time(bool thread = false);
+
+  /**
+   * Get the peak resident set size of the process so far, in bytes.
+   */
+  static uint64_t peak_rss();
+
+  /**
+   * Get the name of [phase].
+   */
+  static const char *name(Phase phase);
+
+ private:
+  typedef std::vector<std::pair<std::string, uint64_t>> Values;
+
+  static void set(Values *values, const std::string &name, uint64_t value);
+
+  /**
+   * Write the JSON object to [file], either indented over several lines or
+   * on one line.
+   */
+  void write_object(FILE *file, bool one_line) const;
+
+  bool thread_cpu_;
+
+  double wall_[num_phases] = {};
+  double cpu_[num_phases] = {};
+  uint64_t rss_[num_phases] = {};
+  std::vector<std::pair<std::string, std::string>> strings_;
+  Values counters_;
+  Values memory_;
+};
+}  // namespace deweight
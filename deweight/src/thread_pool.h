@@ -0,0 +1,66 @@
+/******************************************
+Copyright (c) 2020, Jeffrey Dudek
+******************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace deweight {
+/**
+ * A fixed set of worker threads that run submitted tasks in FIFO order.
+ *
+ * A pool of size 1 has no workers; tasks run inline on the submitting thread.
+ * Tasks must not block on the results of other tasks in the same pool.
+ */
+class ThreadPool {
+ public:
+  explicit ThreadPool(size_t num_threads);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool& other) = delete;
+  ThreadPool& operator=(const ThreadPool& other) = delete;
+
+  /**
+   * Get the number of threads that can run tasks concurrently.
+   */
+  size_t size() const { return workers_.empty() ? 1 : workers_.size(); }
+
+  /**
+   * Schedule a task and return a future for its result.
+   */
+  template <typename F>
+  std::future<typename std::result_of<F()>::type> submit(F task) {
+    typedef typename std::result_of<F()>::type Result;
+    auto packaged = std::make_shared<std::packaged_task<Result()>>(task);
+    std::future<Result> result = packaged->get_future();
+    if (workers_.empty()) {
+      (*packaged)();
+      return result;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.push([packaged]() { (*packaged)(); });
+    }
+    ready_.notify_one();
+    return result;
+  }
+
+ private:
+  void run();
+
+  std::vector<std::thread> workers_;
+  std::queue<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  bool stopping_ = false;
+};
+}  // namespace deweight
@@ -1,4 +1,5 @@
 import argparse
+import math
 import os
 import tempfile
 import subprocess
@@ -21,10 +22,15 @@ def run(args):
         # Record reduction information from DeWeight
         unweighted_formula.seek(0)
         lower_approx, upper_approx = 1, 1
+        log2_normalize = None
         for line in unweighted_formula:
-            if line.startswith('c denom'):
+            if line.startswith('c denom-factored'):
+                output_pair("Normalization", " ".join(line.split()[2:]))
+            elif line.startswith('c log2denom'):
+                log2_normalize = float(line.split()[-1])
+            elif line.startswith('c denom'):
                 output_pair("Normalization", line.split()[-1])
-                normalize = float(line.split()[-1])
+                log2_normalize = math.log2(int(line.split()[-1]))
             elif line.startswith('c deweight time'):
                 output_pair("Deweight Time", line.split()[-1])
             elif line.startswith('c adjust w'):
@@ -69,7 +75,7 @@ def run(args):
                 components = line.split()[-1].split("*")  # solutions are of the form "A*2**B"
                 solutions = int(components[0]) * (2 ** int(components[-1]))
                 output_pair("Solutions", solutions)
-                probability = float(solutions) / float(normalize)
+                probability = divide_log2(solutions, log2_normalize)
                 output_pair("Probability", probability)
                 if exact:
                     lower_bound = lower_approx * probability
@@ -85,6 +91,13 @@ def log(line, **kwargs):
     sys.stderr.flush()
 
 
+def divide_log2(value, log2_denom):
+    # Work in log space, since the denominator may overflow a float
+    if value == 0:
+        return 0.0
+    return 2 ** (math.log2(value) - log2_denom)
+
+
 def parse_rational(rational):
     parts = rational.split("/")
     return float(parts[0]) / float(parts[1])
@@ -100,6 +113,7 @@ if __name__ == "__main__":
     parser.add_argument("--dyadic", type=int, help="Use dyadic reduction with [arg] bits per weight.", default=0)
     parser.add_argument("--rounding", type=str, help="Rounding used to adjust weight of positive literal.", default="")
     parser.add_argument("--weights", type=str, help="Format of weights to parse from CNF.", default="")
+    parser.add_argument("--factored", action="store_true", help="Keep the normalization factored into prime powers.")
     parser.add_argument("--approxmc", type=str, help="Path to ApproxMC (Relative to script)", default="./approxmc")
     parser.add_argument("--epsilon", type=float, help="Epsilon for ApproxMC", default=0.8)
     parser.add_argument("--delta", type=float, help="Delta for ApproxMC", default=0.2)
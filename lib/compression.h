@@ -0,0 +1,572 @@
+/******************************************
+Copyright (c) 2020, Jeffrey Dudek
+******************************************/
+
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <streambuf>
+#include <string>
+
+#ifdef USE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef USE_LZMA
+#include <lzma.h>
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
+static const size_t compression_chunk = 1 << 20;
+
+enum class Compression {none, gzip, xz, zstd};
+
+/**
+ * Identify the compression format of a stream from its first bytes.
+ */
+inline Compression detectCompression(const char* data, size_t size)
+{
+    const unsigned char* magic = reinterpret_cast<const unsigned char*>(data);
+    if (size >= 2 && magic[0] == 0x1f && magic[1] == 0x8b)
+        return Compression::gzip;
+    if (size >= 6 && memcmp(magic, "\xfd" "7zXZ\0", 6) == 0)
+        return Compression::xz;
+    if (size >= 4 && memcmp(magic, "\x28\xb5\x2f\xfd", 4) == 0)
+        return Compression::zstd;
+    return Compression::none;
+}
+
+inline const char* compressionName(Compression format)
+{
+    switch (format) {
+        case Compression::gzip: return "gzip";
+        case Compression::xz: return "xz";
+        case Compression::zstd: return "zstd";
+        default: return "uncompressed";
+    }
+}
+
+/**
+ * Return true if this build can read and write [format].
+ */
+inline bool compressionSupported(Compression format)
+{
+    switch (format) {
+#ifdef USE_ZLIB
+        case Compression::gzip: return true;
+#endif
+#ifdef USE_LZMA
+        case Compression::xz: return true;
+#endif
+#ifdef USE_ZSTD
+        case Compression::zstd: return true;
+#endif
+        case Compression::none: return true;
+        default: return false;
+    }
+}
+
+/**
+ * Parse a compression format name as given on the command line.
+ */
+inline bool parseCompression(const std::string& name, Compression& format)
+{
+    if (name == "none") {
+        format = Compression::none;
+    } else if (name == "gz" || name == "gzip") {
+        format = Compression::gzip;
+    } else if (name == "xz") {
+        format = Compression::xz;
+    } else if (name == "zst" || name == "zstd") {
+        format = Compression::zstd;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Reads a file, transparently decompressing it if it starts with the magic
+ * bytes of a supported compression format.
+ */
+class InputStream
+{
+    FILE* file;
+    Compression format;
+    // The format whose decoder state is allocated, if any
+    Compression decoder;
+    bool done;
+    // Whether the input was corrupt or could not be decoded
+    bool error;
+    std::unique_ptr<char[]> buf;
+    size_t pos;
+    size_t size;
+    size_t total;
+#ifdef USE_ZLIB
+    z_stream gz;
+#endif
+#ifdef USE_LZMA
+    lzma_stream xz;
+#endif
+#ifdef USE_ZSTD
+    ZSTD_DStream* zs;
+#endif
+
+    // Make more compressed input available; returns false at end of file
+    bool refill()
+    {
+        if (pos < size) return true;
+        pos = 0;
+        size = fread(buf.get(), 1, compression_chunk, file);
+        return size > 0;
+    }
+
+    void fail(const char* message)
+    {
+        std::cerr << "Error: Corrupt " << compressionName(format)
+                  << " input (" << message << ")" << std::endl;
+        done = true;
+        error = true;
+    }
+
+    void initFailed()
+    {
+        std::cerr << "Error: Unable to start the " << compressionName(format)
+                  << " decoder" << std::endl;
+        done = true;
+        error = true;
+    }
+
+    // Read up to [count] decompressed bytes into [out]
+    size_t decode(char* out, size_t count)
+    {
+        if (done) return 0;
+        switch (format) {
+            case Compression::none: {
+                if (pos < size) {
+                    size_t n = std::min(count, size - pos);
+                    memcpy(out, buf.get() + pos, n);
+                    pos += n;
+                    return n;
+                }
+                return fread(out, 1, count, file);
+            }
+#ifdef USE_ZLIB
+            case Compression::gzip: {
+                gz.next_out = reinterpret_cast<Bytef*>(out);
+                gz.avail_out = count;
+                while (gz.avail_out > 0) {
+                    refill();
+                    gz.next_in = reinterpret_cast<Bytef*>(buf.get() + pos);
+                    gz.avail_in = size - pos;
+                    int ret = inflate(&gz, Z_NO_FLUSH);
+                    pos = size - gz.avail_in;
+                    if (ret == Z_STREAM_END) {
+                        // Continue with the next member, if any
+                        if (!refill()) {
+                            done = true;
+                            break;
+                        }
+                        inflateReset(&gz);
+                    } else if (ret == Z_BUF_ERROR) {
+                        if (!refill()) fail("unexpected end of file");
+                        break;
+                    } else if (ret != Z_OK) {
+                        fail(gz.msg != nullptr ? gz.msg : "inflate failed");
+                        break;
+                    }
+                }
+                return count - gz.avail_out;
+            }
+#endif
+#ifdef USE_LZMA
+            case Compression::xz: {
+                xz.next_out = reinterpret_cast<uint8_t*>(out);
+                xz.avail_out = count;
+                while (xz.avail_out > 0) {
+                    lzma_action action = refill() ? LZMA_RUN : LZMA_FINISH;
+                    xz.next_in = reinterpret_cast<uint8_t*>(buf.get() + pos);
+                    xz.avail_in = size - pos;
+                    lzma_ret ret = lzma_code(&xz, action);
+                    pos = size - xz.avail_in;
+                    if (ret == LZMA_STREAM_END) {
+                        done = true;
+                        break;
+                    } else if (ret != LZMA_OK) {
+                        fail("lzma_code failed");
+                        break;
+                    }
+                }
+                return count - xz.avail_out;
+            }
+#endif
+#ifdef USE_ZSTD
+            case Compression::zstd: {
+                ZSTD_outBuffer output = {out, count, 0};
+                while (output.pos < output.size) {
+                    bool more = refill();
+                    ZSTD_inBuffer input = {buf.get(), size, pos};
+                    size_t before = output.pos;
+                    size_t ret = ZSTD_decompressStream(zs, &output, &input);
+                    pos = input.pos;
+                    if (ZSTD_isError(ret)) {
+                        fail(ZSTD_getErrorName(ret));
+                        break;
+                    }
+                    if (!more && output.pos == before) {
+                        if (ret != 0) fail("unexpected end of file");
+                        done = true;
+                        break;
+                    }
+                }
+                return output.pos;
+            }
+#endif
+            default:
+                return 0;
+        }
+    }
+
+    // Peek at the magic bytes of [file] and get its decoder ready, reusing
+    // the one set up so far if the format is the same
+    void open()
+    {
+        done = false;
+        error = false;
+        pos = 0;
+        size = 0;
+        total = 0;
+        // Keep the magic bytes in the buffer
+        while (size < 6) {
+            size_t read = fread(buf.get() + size, 1, 6 - size, file);
+            if (read == 0) break;
+            size += read;
+        }
+        format = detectCompression(buf.get(), size);
+        if (!compressionSupported(format)) {
+            std::cerr << "Error: Input is " << compressionName(format)
+                      << "-compressed, but this build does not support it"
+                      << std::endl;
+            done = true;
+            error = true;
+            return;
+        }
+        if (format != decoder) release();
+
+        switch (format) {
+#ifdef USE_ZLIB
+            case Compression::gzip:
+                if (decoder == Compression::gzip) {
+                    if (inflateReset(&gz) != Z_OK) initFailed();
+                    break;
+                }
+                memset(&gz, 0, sizeof(gz));
+                decoder = Compression::gzip;
+                if (inflateInit2(&gz, 15 + 32) != Z_OK) initFailed();
+                break;
+#endif
+#ifdef USE_LZMA
+            case Compression::xz:
+                if (decoder != Compression::xz) {
+                    xz = LZMA_STREAM_INIT;
+                    decoder = Compression::xz;
+                }
+                // Reinitializing a stream keeps its memory when it can
+                if (lzma_stream_decoder(&xz, UINT64_MAX, LZMA_CONCATENATED)
+                    != LZMA_OK) initFailed();
+                break;
+#endif
+#ifdef USE_ZSTD
+            case Compression::zstd:
+                if (decoder != Compression::zstd) {
+                    zs = ZSTD_createDStream();
+                    decoder = Compression::zstd;
+                }
+                if (zs == nullptr || ZSTD_isError(ZSTD_initDStream(zs))) {
+                    initFailed();
+                }
+                break;
+#endif
+            default:
+                break;
+        }
+    }
+
+    // Free the decoder state, if any
+    void release()
+    {
+        switch (decoder) {
+#ifdef USE_ZLIB
+            case Compression::gzip: inflateEnd(&gz); break;
+#endif
+#ifdef USE_LZMA
+            case Compression::xz: lzma_end(&xz); break;
+#endif
+#ifdef USE_ZSTD
+            case Compression::zstd: ZSTD_freeDStream(zs); break;
+#endif
+            default: break;
+        }
+        decoder = Compression::none;
+    }
+
+public:
+    explicit InputStream(FILE* f) :
+        file(f)
+        , format(Compression::none)
+        , decoder(Compression::none)
+        , done(false)
+        , error(false)
+        , buf(new char[compression_chunk])
+        , pos(0)
+        , size(0)
+        , total(0)
+    {
+        open();
+    }
+
+    ~InputStream()
+    {
+        release();
+    }
+
+    InputStream(const InputStream&) = delete;
+    InputStream& operator=(const InputStream&) = delete;
+
+    Compression compression() const { return format; }
+
+    /**
+     * Read [f] from now on, keeping the buffer and, if [f] has the same
+     * compression format, the decoder. Errors and statistics start over.
+     */
+    void reset(FILE* f)
+    {
+        file = f;
+        open();
+    }
+
+    /**
+     * Read up to [count] decompressed bytes into [out].
+     *
+     * Returns the number of bytes read, or 0 at the end of the input.
+     */
+    size_t read(char* out, size_t count)
+    {
+        size_t n = decode(out, count);
+        total += n;
+        return n;
+    }
+
+    /**
+     * Return true if the input was found to be corrupt or truncated, or
+     * could not be decoded; it then ends early.
+     */
+    bool failed() const { return error; }
+
+    /**
+     * Number of decompressed bytes read so far.
+     */
+    size_t bytesRead() const { return total; }
+};
+
+/**
+ * Reader for StreamBuffer<InputStream*, IS>.
+ */
+struct IS {
+    static inline int read(void* buf, size_t num, size_t count, InputStream* f)
+    {
+        return f->read(static_cast<char*>(buf), num*count);
+    }
+};
+
+/**
+ * A stream buffer that compresses everything written to it into a file
+ * descriptor. The compressed stream is finished when it is destroyed.
+ */
+class CompressingStreambuf : public std::streambuf
+{
+    int fd;
+    Compression format;
+    bool finished;
+    bool failed;
+    std::unique_ptr<char[]> in;
+    std::unique_ptr<char[]> out;
+#ifdef USE_ZLIB
+    z_stream gz;
+#endif
+#ifdef USE_LZMA
+    lzma_stream xz;
+#endif
+#ifdef USE_ZSTD
+    ZSTD_CStream* zs;
+#endif
+
+    bool writeAll(const char* data, size_t length)
+    {
+        while (length > 0) {
+            ssize_t written = ::write(fd, data, length);
+            if (written < 0) return false;
+            data += written;
+            length -= written;
+        }
+        return true;
+    }
+
+    // Compress the pending input, and end the stream if [finish]
+    bool compress(bool finish)
+    {
+        const char* data = pbase();
+        size_t length = pptr() - pbase();
+        setp(in.get(), in.get() + compression_chunk);
+        if (failed) return false;
+        bool ok = true;
+        switch (format) {
+#ifdef USE_ZLIB
+            case Compression::gzip: {
+                gz.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+                gz.avail_in = length;
+                int ret;
+                do {
+                    gz.next_out = reinterpret_cast<Bytef*>(out.get());
+                    gz.avail_out = compression_chunk;
+                    ret = deflate(&gz, finish ? Z_FINISH : Z_NO_FLUSH);
+                    ok = ok && writeAll(out.get(),
+                                        compression_chunk - gz.avail_out);
+                } while (gz.avail_out == 0 || (finish && ret == Z_OK));
+                break;
+            }
+#endif
+#ifdef USE_LZMA
+            case Compression::xz: {
+                xz.next_in = reinterpret_cast<const uint8_t*>(data);
+                xz.avail_in = length;
+                lzma_ret ret;
+                do {
+                    xz.next_out = reinterpret_cast<uint8_t*>(out.get());
+                    xz.avail_out = compression_chunk;
+                    ret = lzma_code(&xz, finish ? LZMA_FINISH : LZMA_RUN);
+                    ok = ok && writeAll(out.get(),
+                                        compression_chunk - xz.avail_out);
+                } while (xz.avail_out == 0 || (finish && ret == LZMA_OK));
+                break;
+            }
+#endif
+#ifdef USE_ZSTD
+            case Compression::zstd: {
+                ZSTD_inBuffer input = {data, length, 0};
+                size_t remaining;
+                do {
+                    ZSTD_outBuffer output = {out.get(), compression_chunk, 0};
+                    remaining = ZSTD_compressStream2(
+                        zs, &output, &input, finish ? ZSTD_e_end : ZSTD_e_continue);
+                    if (ZSTD_isError(remaining)) return false;
+                    ok = ok && writeAll(out.get(), output.pos);
+                } while (input.pos < input.size || (finish && remaining != 0));
+                break;
+            }
+#endif
+            default:
+                ok = writeAll(data, length);
+                break;
+        }
+        return ok;
+    }
+
+protected:
+    int_type overflow(int_type ch) override
+    {
+        if (!compress(false)) return traits_type::eof();
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    int sync() override
+    {
+        // Leave data in the compressor; flushing it would hurt the ratio
+        return compress(false) ? 0 : -1;
+    }
+
+public:
+    /**
+     * Compress into [fd] with [format], which must be supported.
+     */
+    CompressingStreambuf(int f, Compression fmt) :
+        fd(f)
+        , format(fmt)
+        , finished(false)
+        , failed(false)
+        , in(new char[compression_chunk])
+        , out(new char[compression_chunk])
+    {
+        setp(in.get(), in.get() + compression_chunk);
+        switch (format) {
+#ifdef USE_ZLIB
+            case Compression::gzip:
+                memset(&gz, 0, sizeof(gz));
+                failed = deflateInit2(&gz, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                                      15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK;
+                break;
+#endif
+#ifdef USE_LZMA
+            case Compression::xz:
+                xz = LZMA_STREAM_INIT;
+                failed = lzma_easy_encoder(&xz, LZMA_PRESET_DEFAULT,
+                                           LZMA_CHECK_CRC64) != LZMA_OK;
+                break;
+#endif
+#ifdef USE_ZSTD
+            case Compression::zstd:
+                zs = ZSTD_createCStream();
+                failed = zs == nullptr
+                    || ZSTD_isError(ZSTD_CCtx_setParameter(
+                           zs, ZSTD_c_compressionLevel, ZSTD_CLEVEL_DEFAULT));
+                break;
+#endif
+            default:
+                break;
+        }
+    }
+
+    ~CompressingStreambuf()
+    {
+        finish();
+        switch (format) {
+#ifdef USE_ZLIB
+            case Compression::gzip: deflateEnd(&gz); break;
+#endif
+#ifdef USE_LZMA
+            case Compression::xz: lzma_end(&xz); break;
+#endif
+#ifdef USE_ZSTD
+            case Compression::zstd: ZSTD_freeCStream(zs); break;
+#endif
+            default: break;
+        }
+    }
+
+    CompressingStreambuf(const CompressingStreambuf&) = delete;
+    CompressingStreambuf& operator=(const CompressingStreambuf&) = delete;
+
+    /**
+     * Compress all pending data and end the compressed stream.
+     */
+    bool finish()
+    {
+        if (finished) return true;
+        finished = true;
+        return compress(true);
+    }
+};
+
+#endif //COMPRESSION_H
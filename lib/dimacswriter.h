@@ -0,0 +1,523 @@
+/******************************************
+Copyright (c) 2020, Jeffrey Dudek
+******************************************/
+
+#ifndef DIMACSWRITER_H
+#define DIMACSWRITER_H
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spscqueue.h"
+
+static const size_t writer_chunk = 1 << 20;
+// Blocks are page aligned, so that the kernel can map rather than copy them
+static const size_t writer_alignment = 4096;
+
+static const char digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/**
+ * Number of decimal digits in [value].
+ */
+inline size_t countDigits(uint64_t value)
+{
+    size_t count = 1;
+    for (;;) {
+        if (value < 10) return count;
+        if (value < 100) return count + 1;
+        if (value < 1000) return count + 2;
+        if (value < 10000) return count + 3;
+        value /= 10000;
+        count += 4;
+    }
+}
+
+/**
+ * Write the decimal digits of [value] to [out] two at a time, returning
+ * their number. [out] must have room for 20 characters.
+ */
+inline size_t formatUInt(uint64_t value, char* out)
+{
+    size_t length = countDigits(value);
+    char* p = out + length;
+    while (value >= 100) {
+        size_t pair = (value % 100) * 2;
+        value /= 100;
+        p -= 2;
+        memcpy(p, digit_pairs + pair, 2);
+    }
+    if (value >= 10) {
+        memcpy(p - 2, digit_pairs + value * 2, 2);
+    } else {
+        p[-1] = static_cast<char>('0' + value);
+    }
+    return length;
+}
+
+/**
+ * Write [value] in decimal to [out], returning the number of characters.
+ * [out] must have room for 21 characters.
+ */
+inline size_t formatInt(int64_t value, char* out)
+{
+    if (value >= 0) return formatUInt(value, out);
+    out[0] = '-';
+    return 1 + formatUInt(-static_cast<uint64_t>(value), out + 1);
+}
+
+/**
+ * Append [value] in decimal to [str].
+ */
+inline void appendInt(std::string& str, int64_t value)
+{
+    char digits[24];
+    str.append(digits, formatInt(value, digits));
+}
+
+/**
+ * Buffers DIMACS output and writes it in large blocks, either straight to a
+ * file descriptor with write(2) or to a std::ostream (e.g. to compress it).
+ *
+ * After startBackground(), full blocks are handed to a writer thread, so
+ * that producing the output overlaps with writing (and compressing) it.
+ *
+ * Large blocks that are already in memory skip the buffer: they are written
+ * together with it by writev(2), or (see enableSplice) moved into a pipe
+ * with vmsplice(2). The number of bytes written and the time spent writing
+ * them are counted for statistics.
+ */
+class DimacsWriter
+{
+    struct Block {
+        char* data;
+        size_t size;
+        // Whether the block is one of ours, to be reused once written
+        bool owned;
+    };
+
+    struct FreeDeleter {
+        void operator()(char* p) const { free(p); }
+    };
+
+    int fd;
+    std::ostream* stream;
+    std::vector<std::unique_ptr<char, FreeDeleter>> storage;
+    char* buf;
+    size_t used;
+    std::atomic<bool> failed;
+    bool splice;
+
+    // Statistics, updated by whichever thread writes
+    std::atomic<uint64_t> bytes;
+    std::atomic<int64_t> nanoseconds;
+
+    // Background writing: full blocks go to the writer thread through
+    // [pending] and come back through [done]; a null block stops it
+    std::thread writer;
+    std::unique_ptr<SpscQueue<Block>> pending;
+    std::unique_ptr<SpscQueue<Block>> done;
+    std::vector<char*> spare;
+    size_t capacity;
+    size_t outstanding;
+
+    static char* allocate()
+    {
+        void* p = nullptr;
+        if (posix_memalign(&p, writer_alignment, writer_chunk) != 0) throw std::bad_alloc();
+        return static_cast<char*>(p);
+    }
+
+    void count(size_t length, std::chrono::steady_clock::time_point start)
+    {
+        bytes.fetch_add(length, std::memory_order_relaxed);
+        nanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+    }
+
+    // Write all of [parts] to the file descriptor in as few calls as possible
+    void drainVector(struct iovec* parts, int num_parts)
+    {
+        while (num_parts > 0) {
+            ssize_t written = ::writev(fd, parts, num_parts);
+            if (written < 0) {
+                failed = true;
+                return;
+            }
+            while (num_parts > 0 && static_cast<size_t>(written) >= parts->iov_len) {
+                written -= parts->iov_len;
+                parts++;
+                num_parts--;
+            }
+            if (num_parts > 0) {
+                parts->iov_base = static_cast<char*>(parts->iov_base) + written;
+                parts->iov_len -= written;
+            }
+        }
+    }
+
+    // Move [data] into the output pipe without copying it
+    void drainSplice(const char* data, size_t length)
+    {
+#ifdef __linux__
+        while (length > 0) {
+            struct iovec part = {const_cast<char*>(data), length};
+            ssize_t written = ::vmsplice(fd, &part, 1, 0);
+            if (written < 0) {
+                // Not supported after all; write the rest normally
+                splice = false;
+                drainVector(&part, 1);
+                return;
+            }
+            data += written;
+            length -= written;
+        }
+#else
+        struct iovec part = {const_cast<char*>(data), length};
+        drainVector(&part, 1);
+#endif
+    }
+
+    void drain(const char* data, size_t length, bool mapped = false)
+    {
+        if (failed || length == 0) return;
+        auto start = std::chrono::steady_clock::now();
+        if (stream != nullptr) {
+            stream->write(data, length);
+            if (!*stream) failed = true;
+        } else if (mapped && splice) {
+            drainSplice(data, length);
+        } else {
+            struct iovec part = {const_cast<char*>(data), length};
+            drainVector(&part, 1);
+        }
+        count(length, start);
+    }
+
+    // Write the buffer followed by [data], which is not copied
+    void drainWith(const char* data, size_t length, bool mapped)
+    {
+        if (stream != nullptr || (mapped && splice) || failed) {
+            drain(buf, used);
+            drain(data, length, mapped);
+        } else {
+            auto start = std::chrono::steady_clock::now();
+            struct iovec parts[2] = {{buf, used}, {const_cast<char*>(data), length}};
+            drainVector(parts, 2);
+            count(used + length, start);
+        }
+        used = 0;
+    }
+
+    void runWriter()
+    {
+        Block block;
+        for (;;) {
+            pending->pop(block);
+            if (block.data == nullptr) return;
+            drain(block.data, block.size, !block.owned);
+            done->tryPush(block);
+        }
+    }
+
+    // Take back one block written by the writer thread
+    void reclaim()
+    {
+        Block block;
+        done->pop(block);
+        outstanding--;
+        if (block.owned) spare.push_back(block.data);
+    }
+
+    // Queue [block] for the writer thread
+    void enqueue(const Block& block)
+    {
+        while (outstanding >= capacity) reclaim();
+        pending->tryPush(block);
+        outstanding++;
+    }
+
+    // Hand the buffer to the writer thread and continue in a spare one
+    void submit()
+    {
+        if (used == 0) return;
+        enqueue({buf, used, true});
+        while (spare.empty()) reclaim();
+        buf = spare.back();
+        spare.pop_back();
+        used = 0;
+    }
+
+    // Wait for the writer thread to finish every submitted block
+    void wait()
+    {
+        while (outstanding > 0) reclaim();
+    }
+
+    // Make room for [length] more characters in the buffer
+    void reserve(size_t length)
+    {
+        if (used + length <= writer_chunk) return;
+        if (writer.joinable()) {
+            submit();
+        } else {
+            drain(buf, used);
+            used = 0;
+        }
+    }
+
+    // Write [data] without copying it if it is large enough
+    void writeBlock(const char* data, size_t length, bool mapped)
+    {
+        if (length >= writer_chunk / 2) {
+            if (!writer.joinable()) {
+                drainWith(data, length, mapped);
+                return;
+            }
+            if (mapped) {
+                // [data] stays valid, so the writer thread can take it as is
+                submit();
+                enqueue({const_cast<char*>(data), length, false});
+                return;
+            }
+        }
+        while (length > 0) {
+            // The writer thread may outlive [data], so copy it in pieces
+            reserve(std::min(length, writer_chunk));
+            size_t piece = std::min(length, writer_chunk - used);
+            memcpy(buf + used, data, piece);
+            used += piece;
+            data += piece;
+            length -= piece;
+        }
+    }
+
+public:
+    explicit DimacsWriter(int f) :
+        fd(f)
+        , stream(nullptr)
+        , used(0)
+        , failed(false)
+        , splice(false)
+        , bytes(0)
+        , nanoseconds(0)
+        , capacity(0)
+        , outstanding(0)
+    {
+        storage.emplace_back(allocate());
+        buf = storage[0].get();
+    }
+
+    explicit DimacsWriter(std::ostream* out) :
+        fd(-1)
+        , stream(out)
+        , used(0)
+        , failed(false)
+        , splice(false)
+        , bytes(0)
+        , nanoseconds(0)
+        , capacity(0)
+        , outstanding(0)
+    {
+        storage.emplace_back(allocate());
+        buf = storage[0].get();
+    }
+
+    ~DimacsWriter()
+    {
+        flush();
+        if (writer.joinable()) {
+            pending->tryPush({nullptr, 0, false});
+            writer.join();
+        }
+    }
+
+    DimacsWriter(const DimacsWriter&) = delete;
+    DimacsWriter& operator=(const DimacsWriter&) = delete;
+
+    /**
+     * Write blocks on a separate thread, keeping up to [num_blocks] blocks
+     * in flight.
+     */
+    void startBackground(size_t num_blocks = 4)
+    {
+        if (writer.joinable()) return;
+        capacity = num_blocks;
+        pending.reset(new SpscQueue<Block>(num_blocks));
+        done.reset(new SpscQueue<Block>(num_blocks));
+        for (size_t i = 1; i < num_blocks; i++) {
+            storage.emplace_back(allocate());
+            spare.push_back(storage.back().get());
+        }
+        writer = std::thread(&DimacsWriter::runWriter, this);
+    }
+
+    /**
+     * Splice blocks given to writeMapped into the output if it is a pipe,
+     * instead of copying them. The pipe then refers to their pages, so they
+     * must not be modified afterwards (unmapping them is fine). Returns true
+     * if splicing is used.
+     */
+    bool enableSplice()
+    {
+#ifdef __linux__
+        struct stat st;
+        splice = stream == nullptr && fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
+        // Fewer, larger splices (this may fail without privileges)
+        if (splice) fcntl(fd, F_SETPIPE_SZ, static_cast<int>(writer_chunk));
+#endif
+        return splice;
+    }
+
+    /**
+     * Write out everything buffered. Returns false if any write failed.
+     */
+    bool flush()
+    {
+        if (writer.joinable()) {
+            submit();
+            wait();
+        } else {
+            drain(buf, used);
+            used = 0;
+        }
+        if (stream != nullptr && !failed) {
+            stream->flush();
+            if (!*stream) failed = true;
+        }
+        return !failed;
+    }
+
+    /**
+     * Write to the file descriptor [f] from now on, keeping the blocks
+     * allocated so far. Everything written before must have been flushed;
+     * errors and statistics start over.
+     */
+    void reset(int f)
+    {
+        fd = f;
+        failed = false;
+        splice = false;
+        bytes = 0;
+        nanoseconds = 0;
+    }
+
+    bool ok() const { return !failed; }
+
+    /**
+     * Number of bytes written out so far (before compression, if any).
+     */
+    uint64_t bytesWritten() const { return bytes.load(std::memory_order_relaxed); }
+
+    /**
+     * Time spent writing out blocks so far, in seconds.
+     */
+    double secondsWriting() const { return nanoseconds.load(std::memory_order_relaxed) / 1e9; }
+
+    /**
+     * Describe the bytes written so far and the write throughput.
+     */
+    std::string stats() const
+    {
+        double seconds = secondsWriting();
+        char line[128];
+        snprintf(line, sizeof(line), "%llu bytes in %.3f s (%.1f MB/s)",
+                 static_cast<unsigned long long>(bytesWritten()), seconds,
+                 seconds > 0 ? bytesWritten() / seconds / 1e6 : 0.0);
+        return line;
+    }
+
+    void write(const char* data, size_t length)
+    {
+        writeBlock(data, length, false);
+    }
+
+    /**
+     * Write [data] (e.g. part of a mapped input file), which must stay valid
+     * until the next flush(). Large blocks are then not copied. With
+     * enableSplice, [data] must also never be modified afterwards.
+     */
+    void writeMapped(const char* data, size_t length)
+    {
+        writeBlock(data, length, true);
+    }
+
+    void write(const std::string& str)
+    {
+        write(str.data(), str.size());
+    }
+
+    void writeChar(char c)
+    {
+        reserve(1);
+        buf[used++] = c;
+    }
+
+    void writeInt(int64_t value)
+    {
+        reserve(21);
+        used += formatInt(value, buf + used);
+    }
+
+    /**
+     * Write [value] as printf would with [format] (e.g. "%g").
+     */
+    void writeDouble(double value, const char* format)
+    {
+        reserve(64);
+        int length = snprintf(buf + used, 64, format, value);
+        if (length > 0 && length < 64) {
+            used += length;
+        } else {
+            char large[512];
+            length = snprintf(large, sizeof(large), format, value);
+            if (length > 0) write(large, std::min<size_t>(length, sizeof(large) - 1));
+        }
+    }
+
+    /**
+     * Write a clause literal followed by a space.
+     */
+    void writeLiteral(int literal)
+    {
+        reserve(22);
+        used += formatInt(literal, buf + used);
+        buf[used++] = ' ';
+    }
+
+    /**
+     * End a clause whose literals were written with writeLiteral.
+     */
+    void endClause()
+    {
+        reserve(2);
+        buf[used++] = '0';
+        buf[used++] = '\n';
+    }
+};
+
+#endif //DIMACSWRITER_H
@@ -0,0 +1,225 @@
+/******************************************
+Copyright (c) 2020, Jeffrey Dudek
+******************************************/
+
+#ifndef MEMORYBUFFER_H
+#define MEMORYBUFFER_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <stdio.h>
+#include <iostream>
+#include <limits>
+#include <string>
+
+#include "scan.h"
+
+/**
+ * A read-only memory mapping of a regular file.
+ */
+class MappedFile
+{
+    int fd;
+    const char* map;
+    size_t length;
+
+public:
+    MappedFile() : fd(-1), map(nullptr), length(0) {}
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile()
+    {
+        close();
+    }
+
+    void close()
+    {
+        if (map != nullptr) munmap(const_cast<char*>(map), length);
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+        map = nullptr;
+        length = 0;
+    }
+
+    /**
+     * Map [path] for sequential reading. Returns false if [path] cannot be
+     * opened or is not a regular file (e.g. a pipe), in which case it must
+     * be streamed instead.
+     */
+    bool open(const std::string& path)
+    {
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+            close();
+            return false;
+        }
+
+        length = st.st_size;
+        if (length == 0) return true;
+        void* addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            close();
+            return false;
+        }
+        madvise(addr, length, MADV_SEQUENTIAL);
+        map = static_cast<const char*>(addr);
+        return true;
+    }
+
+    bool isOpen() const { return fd >= 0; }
+    int descriptor() const { return fd; }
+    const char* data() const { return map; }
+    size_t size() const { return length; }
+};
+
+/**
+ * Parses DIMACS tokens directly out of a contiguous block of memory.
+ *
+ * Provides the same interface as StreamBuffer, but never copies or refills.
+ */
+class MemoryBuffer
+{
+    const char* begin;
+    const char* pos;
+    const char* end;
+
+    void advance()
+    {
+        if (pos < end) pos++;
+    }
+    int value()
+    {
+        return operator*();
+    }
+
+public:
+    MemoryBuffer(const char* data, size_t size) :
+        begin(data)
+        , pos(data)
+        , end(data + size)
+    {}
+
+    int  operator *  () {
+        return (pos >= end) ? EOF : *pos;
+    }
+    void operator ++ () {
+        advance();
+    }
+
+    /**
+     * Get the start of the buffer.
+     */
+    const char* data() const {
+        return begin;
+    }
+
+    /**
+     * Get the offset of the current character from the start of the buffer.
+     */
+    size_t position() const {
+        return pos - begin;
+    }
+
+    /**
+     * Get the size of the buffer.
+     */
+    size_t size() const {
+        return end - begin;
+    }
+
+    /**
+     * Move to [offset] from the start of the buffer.
+     */
+    void seek(size_t offset) {
+        pos = begin + offset;
+    }
+
+    void skipWhitespace()
+    {
+        pos = scan::skipBlanks(pos, end);
+    }
+
+    /**
+     * Advance to the end of the current line, without consuming the newline.
+     */
+    void skipToEOL()
+    {
+        pos = scan::findNewline(pos, end);
+    }
+
+    void skipLine()
+    {
+        pos = scan::findLineEnd(pos, end);
+        if (pos < end && *pos == '\n') pos++;
+    }
+
+    template<class T=int32_t>
+    inline bool parseInt(T& ret, size_t lineNum, bool allow_eol = false)
+    {
+        T mult = 1;
+        skipWhitespace();
+        if (value() == '-') {
+            mult = -1;
+            advance();
+        } else if (value() == '+') {
+            advance();
+        }
+
+        char c = value();
+        if (allow_eol && c == '\n') {
+            ret = std::numeric_limits<T>::max();
+            return true;
+        }
+        if (c < '0' || c > '9') {
+            std::cerr
+            << "PARSE ERROR! Unexpected char (dec: '" << c << ")"
+            << " At line " << lineNum
+            << " we expected a number"
+            << std::endl;
+            return false;
+        }
+
+        uint64_t digits = 0;
+        if (!scan::parseDigits(pos, end, digits)
+            || digits > static_cast<uint64_t>(std::numeric_limits<T>::max())) {
+            std::cerr << "PARSE ERROR! At line " << lineNum
+            << " the variable number is to high"
+            << std::endl;
+            return false;
+        }
+        ret = mult*static_cast<T>(digits);
+        return true;
+    }
+
+    void parseString(std::string& str)
+    {
+        skipWhitespace();
+        const char* start = pos;
+        pos = scan::findTokenEnd(pos, end);
+        str.assign(start, pos);
+    }
+
+    void appendLine(std::string& str)
+    {
+        skipWhitespace();
+        const char* start = pos;
+        pos = scan::findNewline(pos, end);
+        str.append(start, pos);
+    }
+
+    bool consume(const char* str) {
+        for (; *str != 0; ++str, advance())
+            if (*str != value())
+                return false;
+        return true;
+    }
+};
+
+#endif //MEMORYBUFFER_H
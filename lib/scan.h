@@ -0,0 +1,184 @@
+/******************************************
+Copyright (c) 2020, Jeffrey Dudek
+******************************************/
+
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * Scanners for DIMACS tokens over a contiguous range of characters.
+ *
+ * Each scanner looks at a whole vector of characters per step (32 bytes with
+ * AVX2, 16 bytes with SSE2) and finishes the range one character at a time.
+ * Build with -march=native (or -mavx2) to use AVX2; without SSE2 only the
+ * scalar loops are used.
+ */
+namespace scan {
+
+#if defined(__AVX2__)
+typedef __m256i Block;
+static const size_t block_size = 32;
+static inline Block load(const char* p)
+{
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+static inline uint32_t equal(Block b, char c)
+{
+    return _mm256_movemask_epi8(_mm256_cmpeq_epi8(b, _mm256_set1_epi8(c)));
+}
+#elif defined(__SSE2__)
+typedef __m128i Block;
+static const size_t block_size = 16;
+static inline Block load(const char* p)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+static inline uint32_t equal(Block b, char c)
+{
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(b, _mm_set1_epi8(c)));
+}
+#endif
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#define SCAN_VECTORIZED 1
+static const uint32_t block_mask = (block_size == 32) ? 0xffffffffu : 0xffffu;
+#endif
+
+/**
+ * Find the first character in [p, end) accepted by [Match], or [end].
+ *
+ * [Match] provides both a scalar test and a bitmask over a whole block.
+ */
+template<class Match>
+static inline const char* find(const char* p, const char* end)
+{
+#ifdef SCAN_VECTORIZED
+    while (end - p >= static_cast<ptrdiff_t>(block_size)) {
+        uint32_t found = Match::block(load(p));
+        if (found != 0) return p + __builtin_ctz(found);
+        p += block_size;
+    }
+#endif
+    while (p < end && !Match::test(*p)) p++;
+    return p;
+}
+
+#ifdef SCAN_VECTORIZED
+#define SCAN_BLOCK(expr) static inline uint32_t block(Block b) { return expr; }
+#else
+#define SCAN_BLOCK(expr)
+#endif
+
+struct Newline {
+    static inline bool test(char c) { return c == '\n'; }
+    SCAN_BLOCK(equal(b, '\n'))
+};
+
+struct LineEnd {
+    static inline bool test(char c) { return c == '\n' || c == '\0'; }
+    SCAN_BLOCK(equal(b, '\n') | equal(b, '\0'))
+};
+
+struct TokenEnd {
+    static inline bool test(char c) { return c == ' ' || c == '\n'; }
+    SCAN_BLOCK(equal(b, ' ') | equal(b, '\n'))
+};
+
+struct NonBlank {
+    static inline bool test(char c) { return c != ' ' && c != '\t' && c != '\r'; }
+    SCAN_BLOCK((equal(b, ' ') | equal(b, '\t') | equal(b, '\r')) ^ block_mask)
+};
+
+#undef SCAN_BLOCK
+
+/**
+ * Find the first newline in [p, end), or [end].
+ */
+static inline const char* findNewline(const char* p, const char* end)
+{
+    return find<Newline>(p, end);
+}
+
+/**
+ * Find the first newline or NUL character in [p, end), or [end].
+ */
+static inline const char* findLineEnd(const char* p, const char* end)
+{
+    return find<LineEnd>(p, end);
+}
+
+/**
+ * Find the first space or newline in [p, end), or [end].
+ */
+static inline const char* findTokenEnd(const char* p, const char* end)
+{
+    return find<TokenEnd>(p, end);
+}
+
+/**
+ * Skip spaces, tabs and carriage returns in [p, end).
+ */
+static inline const char* skipBlanks(const char* p, const char* end)
+{
+    return find<NonBlank>(p, end);
+}
+
+static const uint64_t powers_of_ten[9] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000
+};
+
+/**
+ * Accumulate the decimal digits at the start of [p, end) into [val],
+ * advancing [p] past them.
+ *
+ * Eight digits are converted at a time within a 64-bit word. Returns false
+ * if [val] overflows, leaving [p] somewhere inside the digits.
+ */
+static inline bool parseDigits(const char*& p, const char* end, uint64_t& val)
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while (end - p >= 8) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        // Digits become 0-9; any other byte has its high bit set by one of
+        // the two terms. Carries only run past the first non-digit.
+        uint64_t digits = word ^ 0x3030303030303030ull;
+        uint64_t other = (digits | (digits + 0x7676767676767676ull))
+            & 0x8080808080808080ull;
+        size_t count = other == 0 ? 8 : __builtin_ctzll(other) / 8;
+        if (count == 0) return true;
+
+        // Shift the digits to the top so missing ones act as leading zeros,
+        // then combine pairs, quads and halves
+        digits <<= 8 * (8 - count);
+        digits = (digits * 10 + (digits >> 8)) & 0x00ff00ff00ff00ffull;
+        digits = (digits * 100 + (digits >> 16)) & 0x0000ffff0000ffffull;
+        digits = (digits * 10000 + (digits >> 32)) & 0x00000000ffffffffull;
+
+        uint64_t scale = powers_of_ten[count];
+        if (val > (UINT64_MAX - digits) / scale) return false;
+        val = val * scale + digits;
+        p += count;
+        if (count < 8) return true;
+    }
+#endif
+    while (p < end && *p >= '0' && *p <= '9') {
+        uint64_t digit = *p - '0';
+        if (val > (UINT64_MAX - digit) / 10) return false;
+        val = val * 10 + digit;
+        p++;
+    }
+    return true;
+}
+
+}  // namespace scan
+
+#endif //SCAN_H
@@ -0,0 +1,87 @@
+/******************************************
+Copyright (c) 2020, Jeffrey Dudek
+******************************************/
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <stddef.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+/**
+ * A bounded queue between one producer thread and one consumer thread.
+ *
+ * Pushing and popping are lock-free; a consumer that finds the queue empty
+ * sleeps until the next push instead of spinning.
+ */
+template<class T>
+class SpscQueue
+{
+    std::vector<T> slots;
+    // Next slot to pop and to push, counting from the start
+    std::atomic<size_t> head;
+    std::atomic<size_t> tail;
+    std::atomic<int> sleepers;
+    std::mutex mutex;
+    std::condition_variable pushed;
+
+public:
+    explicit SpscQueue(size_t capacity) :
+        slots(capacity)
+        , head(0)
+        , tail(0)
+        , sleepers(0)
+    {}
+
+    /**
+     * Add [value] to the queue, returning false if the queue is full.
+     */
+    bool tryPush(const T& value)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == slots.size()) return false;
+        slots[t % slots.size()] = value;
+        tail.store(t + 1, std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            pushed.notify_one();
+        }
+        return true;
+    }
+
+    /**
+     * Remove the oldest value into [value], returning false if the queue is
+     * empty.
+     */
+    bool tryPop(T& value)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        value = slots[h % slots.size()];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Remove the oldest value into [value], waiting for one if necessary.
+     */
+    void pop(T& value)
+    {
+        while (!tryPop(value)) {
+            std::unique_lock<std::mutex> lock(mutex);
+            sleepers.fetch_add(1, std::memory_order_seq_cst);
+            // A push after this check will see the sleeper and notify
+            if (tail.load(std::memory_order_seq_cst)
+                == head.load(std::memory_order_relaxed)) {
+                pushed.wait(lock);
+            }
+            sleepers.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+};
+
+#endif //SPSCQUEUE_H
@@ -30,6 +30,8 @@ static const unsigned chunk_limit = 148576;
 #include <memory>
 #include <cmath>
 
+#include "scan.h"
+
 #ifdef USE_ZLIB
 #include <zlib.h>
 struct GZ {
@@ -87,6 +89,34 @@ class StreamBuffer
         return operator*();
     }
 
+    // Move to the first character at or after pos accepted by [Match],
+    // refilling as needed. Returns false at the end of the input.
+    template<class Match>
+    bool scanTo()
+    {
+        for (;;) {
+            pos = scan::find<Match>(buf.get() + pos, buf.get() + size) - buf.get();
+            if (pos < size) return true;
+            assureLookahead();
+            if (pos >= size) return false;
+        }
+    }
+
+    // Append characters up to the first one accepted by [Match] to [str]
+    template<class Match>
+    void appendTo(std::string& str)
+    {
+        for (;;) {
+            const char* start = buf.get() + pos;
+            const char* stop = scan::find<Match>(start, buf.get() + size);
+            str.append(start, stop);
+            pos = stop - buf.get();
+            if (pos < size) return;
+            assureLookahead();
+            if (pos >= size) return;
+        }
+    }
+
 public:
     StreamBuffer(A i) :
         in(i)
@@ -97,6 +127,17 @@ public:
         assureLookahead();
     }
 
+    /**
+     * Read from [i] from now on, keeping the buffer.
+     */
+    void reset(A i)
+    {
+        in = i;
+        pos = 0;
+        size = 0;
+        assureLookahead();
+    }
+
     int  operator *  () {
         return (pos >= size) ? EOF : buf[pos];
     }
@@ -107,23 +148,12 @@ public:
 
     void skipWhitespace()
     {
-        char c = value();
-        while (c == '\t' || c == '\r' || c == ' ') {
-            advance();
-            c = value();
-        }
+        scanTo<scan::NonBlank>();
     }
 
     void skipLine()
     {
-        for (;;) {
-            if (value() == EOF || value() == '\0') return;
-            if (value() == '\n') {
-                advance();
-                return;
-            }
-            advance();
-        }
+        if (scanTo<scan::LineEnd>() && value() == '\n') advance();
     }
 
     bool skipEOL(const size_t lineNum)
@@ -178,7 +208,6 @@ public:
     template<class T=int32_t>
     inline bool parseInt(T& ret, size_t lineNum, bool allow_eol = false)
     {
-        T val = 0;
         T mult = 1;
         skipWhitespace();
         if (value() == '-') {
@@ -202,19 +231,24 @@ public:
             return false;
         }
 
-        while (c >= '0' && c <= '9') {
-            T val2 = val*10 + (c - '0');
-            if (val2 < val) {
-                std::cerr << "PARSE ERROR! At line " << lineNum
-                << " the variable number is to high"
-                << std::endl;
-                return false;
-            }
-            val = val2;
-            advance();
-            c = value();
+        // Digits may run across a refill
+        uint64_t digits = 0;
+        bool ok = true;
+        for (;;) {
+            const char* start = buf.get() + pos;
+            ok = scan::parseDigits(start, buf.get() + size, digits);
+            pos = start - buf.get();
+            if (!ok || pos < size) break;
+            assureLookahead();
+            if (pos >= size) break;
+        }
+        if (!ok || digits > static_cast<uint64_t>(std::numeric_limits<T>::max())) {
+            std::cerr << "PARSE ERROR! At line " << lineNum
+            << " the variable number is to high"
+            << std::endl;
+            return false;
         }
-        ret = mult*val;
+        ret = mult*static_cast<T>(digits);
         return true;
     }
 
@@ -222,19 +256,13 @@ public:
     {
         str.clear();
         skipWhitespace();
-        while (value() != ' ' && value() != '\n' && value() != EOF) {
-            str.push_back(value());
-            advance();
-        }
+        appendTo<scan::TokenEnd>(str);
     }
 
     void appendLine(std::string& str)
     {
         skipWhitespace();
-        while (value() != '\n' && value() != EOF) {
-            str.push_back(value());
-            advance();
-        }
+        appendTo<scan::Newline>(str);
     }
 
     bool consume(const char* str) {
@@ -0,0 +1,87 @@
+/******************************************
+Copyright (c) 2020, Jeffrey Dudek
+******************************************/
+
+/*
+ * Checks of the libdeweight C interface on edge-case weights and options,
+ * run by `make -C deweight check`. Each case reduces the formula (1), over
+ * one variable, and checks the return code and, on success, the normalizing
+ * factor.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "src/deweight.h"
+
+static int failures = 0;
+
+/*
+ * Reduce (1) with weight [pos_num]/[pos_denom] on literal [literal] and
+ * [neg_num]/[neg_denom] on its negation, using [dyadic_bits] and rounding
+ * down (or up, if [round_up]), and check that deweight_reduce returns
+ * [expected_code] and, if that is 0, the denominator [expected_denom].
+ */
+static void check(const char *name, int literal, int64_t pos_num,
+                  int64_t pos_denom, int64_t neg_num, int64_t neg_denom,
+                  int dyadic_bits, int round_up, int expected_code,
+                  const char *expected_denom) {
+  int literals[] = {1, 0};
+  int weighted[] = {literal, -literal};
+  int64_t nums[] = {pos_num, neg_num};
+  int64_t denoms[] = {pos_denom, neg_denom};
+  struct deweight_options options;
+  struct deweight_result result;
+  deweight_default_options(&options);
+  options.dyadic_bits = dyadic_bits;
+  options.rounding = round_up ? DEWEIGHT_ROUND_UP : DEWEIGHT_ROUND_DOWN;
+
+  int code = deweight_reduce(1, literals, 2, weighted, nums, denoms, 2, NULL,
+                             0, &options, &result);
+  if (code != expected_code) {
+    printf("FAIL: %s returned %d instead of %d\n", name, code, expected_code);
+    failures++;
+  } else if (code == 0 && strcmp(result.denominator, expected_denom) != 0) {
+    printf("FAIL: %s gave denominator %s instead of %s\n", name,
+           result.denominator, expected_denom);
+    failures++;
+  }
+  if (code == 0) {
+    deweight_free_result(&result);
+  }
+}
+
+int main(void) {
+  /* Weights 0 and 1 need no auxiliary variables */
+  check("weight 0", 1, 0, 1, 1, 1, 0, 0, 0, "1");
+  check("weight 1", 1, 1, 1, 0, 1, 0, 0, 0, "1");
+  check("weight 2/3", 1, 2, 3, 1, 3, 0, 0, 0, "3");
+  check("dyadic 1/2", 1, 1, 2, 1, 2, 4, 0, 0, "2");
+  check("dyadic 3/4", 1, 3, 4, 1, 4, 4, 0, 0, "4");
+
+  /* Dyadic weights that round to 0 or 1 */
+  check("dyadic 1", 1, 1, 1, 0, 1, 4, 0, 0, "1");
+  check("dyadic 0", 1, 0, 1, 1, 1, 4, 1, 0, "1");
+  check("dyadic 0 rounded down", 1, 0, 1, 1, 1, 4, 0, 0, "16");
+
+  /* Denominators whose product does not fit in 64 bits */
+  check("oversized", 1, 1, INT64_MAX, 1, INT64_MAX - 1, 0, 0, 0,
+        "85070591730234615838173535747377725442");
+  check("oversized dyadic", 1, 1, INT64_MAX, INT64_MAX - 1, INT64_MAX, 30,
+        0, 0, "1073741824");
+
+  /* Invalid weights and options are rejected */
+  check("negative weight", 1, -1, 2, 3, 2, 0, 0, -1, "");
+  check("zero denominator", 1, 1, 0, 1, 2, 0, 0, -1, "");
+  check("unknown literal", 2, 1, 2, 1, 2, 0, 0, -1, "");
+  check("negative dyadic bits", 1, 1, 2, 1, 2, -1, 0, -1, "");
+  check("too many dyadic bits", 1, 1, 2, 1, 2, 31, 0, -1, "");
+
+  if (failures > 0) {
+    printf("%d library checks failed.\n", failures);
+    return 1;
+  }
+  printf("Library checks passed.\n");
+  return 0;
+}
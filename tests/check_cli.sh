@@ -0,0 +1,84 @@
+#!/bin/sh
+# Differential checks of the deweight command line tool, run by
+# `make -C deweight check`.
+#
+# Each formula in tests/cases is reduced in several modes and compared with
+# tests/expected/<case>.<mode> (ignoring the "c deweight time" line). Run with
+# --update to rewrite the expected outputs after an intended change.
+#
+# Usage: check_cli.sh DEWEIGHT [--update]
+# Set USE_ZLIB=1 to also check a gzip round trip.
+
+deweight=$1
+update=$2
+tests=$(dirname "$0")
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+failures=0
+
+# Drop the line that changes from run to run
+strip() {
+  grep -v '^c deweight time'
+}
+
+# Compare the output in $work/out with the expected output [name]
+compare() {
+  if [ "$update" = "--update" ]; then
+    cp "$work/out" "$tests/expected/$1"
+  elif ! cmp -s "$work/out" "$tests/expected/$1"; then
+    echo "FAIL: $1"
+    diff "$tests/expected/$1" "$work/out" | head -n 10
+    failures=$((failures + 1))
+  fi
+}
+
+# Run deweight with the given arguments, writing its messages and then its
+# output (as a regular file, so that --stream applies) to $work/out
+run() {
+  "$deweight" "$@" > "$work/cnf" 2> "$work/err"
+  cat "$work/err" "$work/cnf" | strip > "$work/out"
+}
+
+for input in "$tests"/cases/*.cnf; do
+  name=$(basename "$input" .cnf)
+
+  run -t 1 "$input"
+  compare "$name.general"
+  run -t 1 --dyadic=3 "$input"
+  compare "$name.dyadic"
+  run -t 1 --factored "$input"
+  compare "$name.factored"
+  run -t 1 --stream "$input"
+  compare "$name.stream"
+
+  # Compressed input and output give the same formula
+  if [ "$USE_ZLIB" = "1" ]; then
+    gzip -c "$input" > "$work/in.cnf.gz"
+    "$deweight" -t 1 --compress=gz "$work/in.cnf.gz" > "$work/out.cnf.gz" \
+      2> "$work/err"
+    gzip -dc "$work/out.cnf.gz" | cat "$work/err" - | strip > "$work/out"
+    compare "$name.general"
+  fi
+done
+
+# Parallel parsing and reduction give the same output as one thread, on an
+# input large enough to be split into chunks
+if [ "$update" != "--update" ] && command -v python3 > /dev/null; then
+  python3 "$tests/../bench/generate.py" --vars=40000 --format=mc20 \
+    --denominators=fraction:1000 --seed=1 --output="$work/large.cnf"
+  for mode in "" --stream; do
+    run -t 1 $mode "$work/large.cnf"
+    mv "$work/out" "$work/one"
+    run -t 4 $mode "$work/large.cnf"
+    if ! cmp -s "$work/one" "$work/out"; then
+      echo "FAIL: large.cnf $mode differs between 1 and 4 threads"
+      failures=$((failures + 1))
+    fi
+  done
+fi
+
+if [ "$failures" -gt 0 ]; then
+  echo "$failures command line checks failed."
+  exit 1
+fi
+echo "Command line checks passed."
@@ -12,7 +12,8 @@ Copyright (c) 2020, Jeffrey Dudek
 #include <sstream>
 
 namespace deweight {
-  Formula::Formula(StreamBuffer<FILE*, FN> *in) {
+  template <typename Input>
+  Formula::Formula(Input *in) {
     std::string entry;
     int line_num = 0;
     std::vector<int> lits;
@@ -76,9 +77,12 @@ namespace deweight {
     }
   }
 
+  template Formula::Formula(StreamBuffer<InputStream*, IS> *in);
+  template Formula::Formula(MemoryBuffer *in);
+
   void Formula::add_clause(std::vector<int> literals) {
     for (int literal : literals) {
-      body_.append(std::to_string(literal));
+      appendInt(body_, literal);
       body_.push_back(' ');
     }
     body_.push_back('0');
@@ -86,11 +90,15 @@ namespace deweight {
     num_clauses_ += 1;
   }
 
-  void Formula::write(std::ostream *output) const {
+  void Formula::write(DimacsWriter *output) const {
     // Write header
-    *output << "p cnf " << num_variables_ << " " << num_clauses_ << "\n";
+    output->write("p cnf ", 6);
+    output->writeInt(num_variables_);
+    output->writeChar(' ');
+    output->writeInt(num_clauses_);
+    output->writeChar('\n');
 
     // Write clauses
-    *output << body_;
+    output->write(body_);
   }
 }  // namespace deweight
@@ -9,6 +9,9 @@ Copyright (c) 2020, Jeffrey Dudek
 #include <utility>
 #include <vector>
 
+#include "../../lib/compression.h"
+#include "../../lib/dimacswriter.h"
+#include "../../lib/memorybuffer.h"
 #include "../../lib/streambuffer.h"
 
 namespace deweight {
@@ -21,8 +24,10 @@ class Formula {
   * Parses a file in DIMACS format into a boolean formula.
   *
   * Returns the parsed formula if the DIMACS file is in a valid format.
+  * [in] is either a StreamBuffer or a MemoryBuffer.
   */
-  explicit Formula(StreamBuffer<FILE*, FN> *in);
+  template <typename Input>
+  explicit Formula(Input *in);
 
   Formula(const Formula& other) = default;
   Formula& operator=(const Formula& other) = default;
@@ -40,7 +45,7 @@ class Formula {
   /**
    * Output the DIMACS of this formula, either with or without the weights.
    */
-  void write(std::ostream *output) const;
+  void write(DimacsWriter *output) const;
 
   int num_variables() const { return num_variables_; }
 
@@ -5,7 +5,6 @@ Copyright (c) 2020, Jeffrey Dudek
 #include "src/formula.h"
 
 #include <algorithm>
-#include <iomanip>
 #include <iostream>
 #include <iterator>
 #include <limits>
@@ -73,11 +72,15 @@ namespace deweight {
     }
   }
 
-  void Rational::output(std::ostream *out, bool use_decimals) const {
+  void Rational::output(DimacsWriter *out, bool use_decimals,
+                        const char *decimal_format) const {
     if (use_decimals) {
-      *out << (static_cast<double>(num) / static_cast<double>(denom));
+      out->writeDouble(static_cast<double>(num) / static_cast<double>(denom),
+                       decimal_format);
     } else {
-      *out << num << "/" << denom;
+      out->writeInt(num);
+      out->writeChar('/');
+      out->writeInt(denom);
     }
   }
 
@@ -85,7 +88,8 @@ namespace deweight {
     return Rational(denom - num, denom);
   }
 
-  Formula Formula::parse_DIMACS(StreamBuffer<FILE*, FN> &in) {
+  template <typename Input>
+  Formula Formula::parse_DIMACS(Input &in) {
     Formula result;
     std::string entry;
     int line_num = 0;
@@ -187,6 +191,9 @@ namespace deweight {
     return result;
   }
 
+  template Formula Formula::parse_DIMACS(StreamBuffer<InputStream*, IS> &in);
+  template Formula Formula::parse_DIMACS(MemoryBuffer &in);
+
   bool Formula::set_weight(int literal, Rational weight) {
     if (literal == 0 || abs(literal) > num_variables_) {
       return false;
@@ -204,18 +211,24 @@ namespace deweight {
     }
   }
 
-  void Formula::write(std::ostream *out, bool use_decimals, OutputFormat format) const {
+  void Formula::write(DimacsWriter *out, bool use_decimals, OutputFormat format) const {
     // Write header
-    *out << "p cnf " << num_variables_ << " " << num_clauses_ << "\n";
+    out->write("p cnf ", 6);
+    out->writeInt(num_variables_);
+    out->writeChar(' ');
+    out->writeInt(num_clauses_);
+    out->writeChar('\n');
 
     switch (format) {
       case OutputFormat::cachet:
         for (int variable = 1; variable <= num_variables_; variable++) {
           Rational w = get_weight(variable);
           if (w.num != 1 || w.denom != 1) {
-            *out << "w " << variable << " ";
+            out->write("w ", 2);
+            out->writeInt(variable);
+            out->writeChar(' ');
             w.output(out, use_decimals);
-            *out << "\n";
+            out->writeChar('\n');
           }
         }
         break;
@@ -223,28 +236,35 @@ namespace deweight {
         for (int variable = 1; variable <= num_variables_; variable++) {
           Rational w = get_weight(variable);
           if (w.num != 1 || w.denom != 1) {
-            *out << "w " << variable << " ";
+            out->write("w ", 2);
+            out->writeInt(variable);
+            out->writeChar(' ');
             w.output(out, use_decimals);
-            *out << " 0 \n";
-            *out << "w -" << variable << " ";
+            out->write(" 0 \n", 4);
+            out->write("w -", 3);
+            out->writeInt(variable);
+            out->writeChar(' ');
             w.complement().output(out, use_decimals);
-            *out << " 0 \n";
+            out->write(" 0 \n", 4);
           }
         }
         break;
       case OutputFormat::sdimacs:
-        std::cout << std::setprecision(4) << std::fixed;
         for (int variable : independent_support_) {
           Rational w = get_weight(variable);
-          *out << "r ";
-          w.output(out, use_decimals);
-          *out << " " << variable << " 0\n";
+          out->write("r ", 2);
+          w.output(out, use_decimals, "%.4f");
+          out->writeChar(' ');
+          out->writeInt(variable);
+          out->write(" 0\n", 3);
         }
         std::vector<int> random_vars = independent_support_;
         std::sort(random_vars.begin(), random_vars.end());
         for (int variable = 1; variable <= num_variables_; variable++) {
           if (!std::binary_search(random_vars.begin(), random_vars.end(), variable)) {
-            *out << "e " << variable << " 0\n";
+            out->write("e ", 2);
+            out->writeInt(variable);
+            out->write(" 0\n", 3);
           }
         }
         break;
@@ -252,14 +272,15 @@ namespace deweight {
 
     // Write independent support
     if (independent_support_.size() > 0 && format != OutputFormat::sdimacs) {
-      *out << "c ind";
+      out->write("c ind", 5);
       for (int variable : independent_support_) {
-        *out << " " << variable;
+        out->writeChar(' ');
+        out->writeInt(variable);
       }
-      *out << " 0\n";
+      out->write(" 0\n", 3);
     }
 
     // Write clauses
-    *out << body_;
+    out->write(body_);
   }
 }  // namespace deweight
@@ -9,6 +9,9 @@ Copyright (c) 2020, Jeffrey Dudek
 #include <utility>
 #include <vector>
 
+#include "../../lib/compression.h"
+#include "../../lib/dimacswriter.h"
+#include "../../lib/memorybuffer.h"
 #include "../../lib/streambuffer.h"
 
 namespace deweight {
@@ -29,7 +32,12 @@ class Rational {
 
   Rational complement() const;
 
-  void output(std::ostream *out, bool use_decimals) const;
+  /**
+   * Write the weight as a fraction, or as a decimal formatted with
+   * [decimal_format] (printf style).
+   */
+  void output(DimacsWriter *out, bool use_decimals,
+              const char *decimal_format = "%g") const;
   static Rational parse(std::string decimal);
 
   const int num;
@@ -54,7 +62,7 @@ class Formula {
   /**
    * Output the DIMACS of this formula, with weights as fractions or decimals.
    */
-  void write(std::ostream *out, bool use_decimals, OutputFormat format) const;
+  void write(DimacsWriter *out, bool use_decimals, OutputFormat format) const;
 
   /**
    * Get the weight of a literal.
@@ -87,8 +95,10 @@ class Formula {
   * Parses a file in DIMACS format into a boolean formula.
   *
   * Returns the parsed formula if the DIMACS file is in a valid format.
+  * [in] is either a StreamBuffer or a MemoryBuffer.
   */
-  static Formula parse_DIMACS(StreamBuffer<FILE*, FN> &in);
+  template <typename Input>
+  static Formula parse_DIMACS(Input &in);
 
  private:
   // Number of variables in the formula
@@ -2,10 +2,12 @@
 Copyright (c) 2020, Jeffrey Dudek
 ******************************************/
 
+#include <stdio.h>
 #include <string.h>
 #include <iostream>
 #include <chrono>
 #include <algorithm>
+#include <memory>
 
 #include "../../lib/cxxopts.hpp"
 #include "src/formula.h"
@@ -26,7 +28,15 @@ int main(int argc, char *argv[]) {
      "--output=ganak\tAs \"w [lit] [weight] 0\"\n"
      "--output=sdimacs\tAs \"r [positive weight] [var] 0\" and \"e [var] 0\"",
      cxxopts::value<deweight::OutputFormat>()->default_value("cachet"))
-    ("h, help", "Print usage");
+    ("z, compress", "Compress the output with [arg] (gz, xz or zst).",
+     cxxopts::value<std::string>())
+    ("v, verbose", "Print statistics about the output to stderr.")
+    ("h, help", "Print usage")
+    ("input", "CNF file to read instead of stdin.",
+     cxxopts::value<std::string>());
+  options.custom_help("[OPTION...] [CNF FILE]");
+  options.positional_help("");
+  options.parse_positional({"input"});
   auto args = options.parse(argc, argv);
   if (args.count("help")) {
     std::cout << options.help() << std::endl;
@@ -39,9 +49,38 @@ int main(int argc, char *argv[]) {
     srand(time(0));
   }
 
-  // Parse formula from stdin
-  StreamBuffer<FILE*, FN> in = StreamBuffer<FILE*, FN>(stdin);
-  auto formula = deweight::Formula::parse_DIMACS(in);
+  // Parse formula, mapping the input file if possible
+  MappedFile input;
+  FILE *stream = stdin;
+  std::unique_ptr<FILE, decltype(&fclose)> opened(nullptr, &fclose);
+  if (args.count("input") > 0) {
+    std::string path = args["input"].as<std::string>();
+    if (!input.open(path)
+        || detectCompression(input.data(), input.size()) != Compression::none) {
+      input.close();
+      opened.reset(fopen(path.c_str(), "rb"));
+      if (opened == nullptr) {
+        std::cerr << "Error: Unable to open " << path << "." << std::endl;
+        return -1;
+      }
+      stream = opened.get();
+    }
+  }
+
+  deweight::Formula formula;
+  if (input.isOpen()) {
+    MemoryBuffer in(input.data(), input.size());
+    formula = deweight::Formula::parse_DIMACS(in);
+  } else {
+    InputStream decoder(stream);
+    StreamBuffer<InputStream*, IS> in(&decoder);
+    formula = deweight::Formula::parse_DIMACS(in);
+    if (decoder.failed()) {
+      std::cerr << "Error: Unable to read formula." << std::endl;
+      return -1;
+    }
+  }
+  opened.reset();
   if (formula.num_variables() == 0) {
     std::cerr << "Error: Unable to read formula." << std::endl;
     return -1;
@@ -103,9 +142,40 @@ int main(int argc, char *argv[]) {
     }
   }
 
+  // Compress the output if requested
+  Compression output_format = Compression::none;
+  if (args.count("compress") > 0) {
+    std::string name = args["compress"].as<std::string>();
+    if (!parseCompression(name, output_format)
+        || !compressionSupported(output_format)) {
+      std::cerr << "Error: Unsupported output compression " << name << "."
+                << std::endl;
+      return -1;
+    }
+  }
+  std::unique_ptr<CompressingStreambuf> compressor;
+  std::unique_ptr<std::ostream> compressed;
+  std::unique_ptr<DimacsWriter> output;
+  if (output_format != Compression::none) {
+    compressor.reset(new CompressingStreambuf(STDOUT_FILENO, output_format));
+    compressed.reset(new std::ostream(compressor.get()));
+    output.reset(new DimacsWriter(compressed.get()));
+  } else {
+    output.reset(new DimacsWriter(STDOUT_FILENO));
+  }
+
   // Output formula with weights
-  formula.write(&std::cout,
+  formula.write(output.get(),
                 args["decimal"].as<bool>(),
                 args["output"].as<deweight::OutputFormat>());
+
+  if (!output->flush()
+      || (compressor != nullptr && !compressor->finish())) {
+    std::cerr << "Error: Unable to write output." << std::endl;
+    return -1;
+  }
+  if (args["verbose"].as<bool>()) {
+    std::cerr << "Output: " << output->stats() << std::endl;
+  }
   return 0;
 }